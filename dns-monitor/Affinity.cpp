@@ -0,0 +1,195 @@
+#include "Affinity.h"
+
+#include <iostream>
+#include <fstream>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+static std::vector<int> worker_cpus;
+static std::atomic<unsigned> next_worker(0);
+static int capture_node = -1;
+
+bool parseCpuList(const std::string &text, std::vector<int> &cpus)
+{
+    const char *position = text.c_str();
+    while (*position != '\0')
+    {
+        char *end;
+        long first = std::strtol(position, &end, 10);
+        if (end == position || first < 0 || first >= CPU_SETSIZE)
+        {
+            return false;
+        }
+        long last = first;
+        if (*end == '-')
+        {
+            position = end + 1;
+            last = std::strtol(position, &end, 10);
+            if (end == position || last < first || last >= CPU_SETSIZE)
+            {
+                return false;
+            }
+        }
+        for (long cpu = first; cpu <= last; cpu++)
+        {
+            cpus.push_back((int)cpu);
+        }
+        if (*end == ',')
+        {
+            end++;
+        }
+        else if (*end != '\0')
+        {
+            return false;
+        }
+        position = end;
+    }
+    return !cpus.empty();
+}
+
+int interfaceNumaNode(const std::string &interface)
+{
+    std::ifstream file("/sys/class/net/" + interface + "/device/numa_node");
+    int node = -1;
+    if (!(file >> node))
+    {
+        return -1;
+    }
+    return node;
+}
+
+// CPUs of a NUMA node as listed by sysfs
+static bool nodeCpus(int node, std::vector<int> &cpus)
+{
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    return std::getline(file, list) && parseCpuList(list, cpus);
+}
+
+// returns 0 or the error number
+static int pinThread(pthread_t thread, const std::vector<int> &cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t i = 0; i < cpus.size(); i++)
+    {
+        CPU_SET(cpus[i], &set);
+    }
+    return pthread_setaffinity_np(thread, sizeof(set), &set);
+}
+
+static std::string formatCpus(const std::vector<int> &cpus)
+{
+    std::string text;
+    for (size_t i = 0; i < cpus.size(); i++)
+    {
+        size_t last = i;
+        while (last + 1 < cpus.size() && cpus[last + 1] == cpus[last] + 1)
+        {
+            last++;
+        }
+        if (!text.empty())
+        {
+            text += ',';
+        }
+        text += std::to_string(cpus[i]);
+        if (last > i)
+        {
+            text += '-' + std::to_string(cpus[last]);
+        }
+        i = last;
+    }
+    return text;
+}
+
+bool initAffinity(const std::string &capture_cpus, const std::string &worker_list, const std::string &interfaces)
+{
+    // node of the first interface, the others are only checked against it
+    size_t start = 0;
+    bool first = true;
+    while (start <= interfaces.size() && !interfaces.empty())
+    {
+        size_t end = interfaces.find(',', start);
+        if (end == std::string::npos)
+        {
+            end = interfaces.size();
+        }
+        std::string name = interfaces.substr(start, end - start);
+        int node = interfaceNumaNode(name);
+        std::cerr << "Interface " << name << ": NUMA node " << (node < 0 ? std::string("unknown") : std::to_string(node)) << std::endl;
+        if (first)
+        {
+            capture_node = node;
+            first = false;
+        }
+        else if (node != capture_node)
+        {
+            std::cerr << "Interfaces are attached to different NUMA nodes, buffers follow the first one" << std::endl;
+        }
+        start = end + 1;
+    }
+
+    std::vector<int> cpus;
+    if (capture_cpus == "auto")
+    {
+        if (capture_node < 0 || !nodeCpus(capture_node, cpus))
+        {
+            std::cerr << "NUMA node of the interface is unknown, the capture thread is not pinned" << std::endl;
+            cpus.clear();
+        }
+    }
+    else if (!capture_cpus.empty() && !parseCpuList(capture_cpus, cpus))
+    {
+        std::cerr << "Invalid CPU list " << capture_cpus << std::endl;
+        return false;
+    }
+
+    if (!worker_list.empty() && !parseCpuList(worker_list, worker_cpus))
+    {
+        std::cerr << "Invalid CPU list " << worker_list << std::endl;
+        return false;
+    }
+
+    if (!cpus.empty())
+    {
+        int error = pinThread(pthread_self(), cpus);
+        if (error != 0)
+        {
+            std::cerr << "Could not pin the capture thread to CPUs " << formatCpus(cpus) << ": " << std::strerror(error) << std::endl;
+            return false;
+        }
+        std::cerr << "Capture thread pinned to CPUs " << formatCpus(cpus) << std::endl;
+    }
+    if (!worker_cpus.empty())
+    {
+        std::cerr << "Worker threads pinned to CPUs " << formatCpus(worker_cpus) << std::endl;
+    }
+    return true;
+}
+
+void pinWorkerThread()
+{
+    if (worker_cpus.empty())
+    {
+        return;
+    }
+    std::vector<int> cpu(1, worker_cpus[next_worker++ % worker_cpus.size()]);
+    pinThread(pthread_self(), cpu);
+}
+
+void bindToCaptureNode(void *address, size_t length)
+{
+    if (capture_node < 0 || capture_node >= (int)(8 * sizeof(unsigned long)))
+    {
+        return;
+    }
+    // preferred rather than bound, the allocation still succeeds when the node is full
+    unsigned long mask = 1UL << capture_node;
+    syscall(SYS_mbind, address, length, MPOL_PREFERRED, &mask, 8 * sizeof(mask), 0);
+}
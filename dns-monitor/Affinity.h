@@ -0,0 +1,42 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+ * Placement of the monitor's threads and buffers on dual-socket machines. The capture
+ * thread is pinned to the CPUs given by --cpus ("auto" takes the CPUs of the NUMA node
+ * the capturing NIC is attached to), background threads take the --worker-cpus list
+ * round-robin. Buffers filled by the NIC are bound to the NIC's node, the rest of the
+ * packet buffers are first touched by the pinned capture thread and so end up local too.
+ */
+
+/**
+ * @brief Parses a CPU list in the kernel format, e.g. "0-3,8,10-11"
+ */
+bool parseCpuList(const std::string &text, std::vector<int> &cpus);
+
+/**
+ * @brief NUMA node of the device behind a network interface, -1 when unknown
+ */
+int interfaceNumaNode(const std::string &interface);
+
+/**
+ * @brief Pins the calling (capture) thread and remembers the worker CPUs
+ *
+ * @param capture_cpus CPU list, "auto" or empty to leave the thread unpinned
+ * @param worker_cpus CPU list for background threads, empty to leave them unpinned
+ * @param interfaces comma separated interfaces the capture runs on
+ * @return false when a list is invalid or the thread could not be pinned
+ */
+bool initAffinity(const std::string &capture_cpus, const std::string &worker_cpus, const std::string &interfaces);
+
+// Pins the calling background thread to the next CPU of the worker list
+void pinWorkerThread();
+
+// Asks the kernel to place the pages of a buffer on the NIC's node, no-op when it is unknown
+void bindToCaptureNode(void *address, size_t length);
+
+#endif
@@ -0,0 +1,518 @@
+#include "Aggregates.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+static const uint16_t size_bucket_limits[SIZE_BUCKETS] = {128, 256, 512, 1024, 1232, 1500, 4096, 65535};
+// 1232 avoids fragmentation on most paths, 1400 and 1452 fit Ethernet with tunnels or without
+static const uint16_t edns_size_limits[EDNS_SIZE_BUCKETS] = {0, 512, 1231, 1232, 1400, 1452, 4096, 65535};
+
+static aggregateWindow second_windows[SECOND_WINDOWS];
+static aggregateWindow minute_windows[MINUTE_WINDOWS];
+static aggregateWindow *current_second = nullptr;
+static aggregateWindow *current_minute = nullptr;
+static FILE *stats_file = nullptr;
+
+static void resetWindow(aggregateWindow &window, int64_t start)
+{
+    std::memset(&window, 0, sizeof(window));
+    window.start = start;
+    window.ecs_node_count = 2;
+}
+
+static inline int sizeBucket(uint16_t size)
+{
+    int bucket = 0;
+    while (size > size_bucket_limits[bucket])
+    {
+        bucket++;
+    }
+    return bucket;
+}
+
+static inline uint64_t prefixKey(const dnsMessageInfo &info)
+{
+    // /24 for IPv4, /48 for IPv6
+    int length = info.family == AF_INET ? 3 : 6;
+    uint64_t key = (uint64_t)info.family << 56;
+    for (int i = 0; i < length; i++)
+    {
+        key |= (uint64_t)info.client[i] << (8 * (5 - i));
+    }
+    return key;
+}
+
+static void addPrefix(aggregateWindow &window, uint64_t key, uint64_t count)
+{
+    uint64_t slot = (key ^ (key >> 17) ^ (key >> 31)) & (PREFIX_SLOTS - 1);
+    // short probe sequence, a window full of distinct prefixes spills into the overflow counter
+    for (int probe = 0; probe < 8; probe++, slot = (slot + 1) & (PREFIX_SLOTS - 1))
+    {
+        if (window.prefix_keys[slot] == key)
+        {
+            window.prefix_counts[slot] += count;
+            return;
+        }
+        if (window.prefix_keys[slot] == 0)
+        {
+            window.prefix_keys[slot] = key;
+            window.prefix_counts[slot] = count;
+            return;
+        }
+    }
+    window.prefix_overflow += count;
+}
+
+static inline int ednsBucket(uint16_t size)
+{
+    int bucket = 0;
+    while (size > edns_size_limits[bucket])
+    {
+        bucket++;
+    }
+    return bucket;
+}
+
+static inline int addressBit(const uint8_t *address, int bit)
+{
+    return (address[bit / 8] >> (7 - bit % 8)) & 1;
+}
+
+// number of leading bits two addresses share, at most limit
+static int commonBits(const uint8_t *a, const uint8_t *b, int limit)
+{
+    int bit = 0;
+    while (bit + 8 <= limit && a[bit / 8] == b[bit / 8])
+    {
+        bit += 8;
+    }
+    while (bit < limit && addressBit(a, bit) == addressBit(b, bit))
+    {
+        bit++;
+    }
+    return bit;
+}
+
+static uint16_t newSubnetNode(aggregateWindow &window, const uint8_t *address, int prefix, uint64_t count)
+{
+    uint16_t index = window.ecs_node_count++;
+    ecsTrieNode &node = window.ecs_nodes[index];
+    std::memset(node.key, 0, sizeof(node.key));
+    std::memcpy(node.key, address, (prefix + 7) / 8);
+    if (prefix % 8 != 0)
+    {
+        node.key[prefix / 8] &= (uint8_t)(0xff00 >> (prefix % 8));
+    }
+    node.length = prefix;
+    node.child[0] = 0;
+    node.child[1] = 0;
+    node.count = count;
+    return index;
+}
+
+// one node per subnet and at most one branching node more, so n subnets take under 2n nodes
+static void addSubnet(aggregateWindow &window, int family, const uint8_t *address, int prefix, uint64_t count)
+{
+    uint16_t node = family == AF_INET ? 0 : 1;
+    for (;;)
+    {
+        ecsTrieNode &current = window.ecs_nodes[node];
+        if (current.length == prefix)
+        {
+            current.count += count;
+            return;
+        }
+        // a split takes two nodes, checked up front so the trie never stays half changed
+        if (window.ecs_node_count + 2 > ECS_TRIE_NODES)
+        {
+            window.ecs_overflow += count;
+            return;
+        }
+
+        int side = addressBit(address, current.length);
+        uint16_t next = current.child[side];
+        if (next == 0)
+        {
+            current.child[side] = newSubnetNode(window, address, prefix, count);
+            return;
+        }
+        const ecsTrieNode &child = window.ecs_nodes[next];
+        int common = commonBits(child.key, address, child.length < prefix ? child.length : prefix);
+        if (common == child.length)
+        {
+            node = next;
+            continue;
+        }
+
+        // the subnet branches off inside the child's prefix
+        uint16_t split = newSubnetNode(window, address, common, common == prefix ? count : 0);
+        window.ecs_nodes[split].child[addressBit(child.key, common)] = next;
+        if (common != prefix)
+        {
+            window.ecs_nodes[split].child[addressBit(address, common)] = newSubnetNode(window, address, prefix, count);
+        }
+        window.ecs_nodes[node].child[side] = split;
+        return;
+    }
+}
+
+// calls visit for every subnet with a count, in address order
+template <typename Visitor>
+static void walkSubnets(const aggregateWindow &window, uint16_t node, int family, Visitor &visit)
+{
+    const ecsTrieNode &entry = window.ecs_nodes[node];
+    if (entry.count != 0)
+    {
+        visit(family, entry.key, entry.length, entry.count);
+    }
+    for (int side = 0; side < 2; side++)
+    {
+        if (entry.child[side] != 0)
+        {
+            walkSubnets(window, entry.child[side], family, visit);
+        }
+    }
+}
+
+template <typename Visitor>
+static void walkSubnets(const aggregateWindow &window, Visitor &visit)
+{
+    walkSubnets(window, 0, AF_INET, visit);
+    walkSubnets(window, 1, AF_INET6, visit);
+}
+
+struct subnetMerger {
+    aggregateWindow &into;
+    void operator()(int family, const uint8_t *address, int prefix, uint64_t count)
+    {
+        addSubnet(into, family, address, prefix, count);
+    }
+};
+
+struct subnetWriter {
+    char kind;
+    long long start;
+    void operator()(int family, const uint8_t *address, int prefix, uint64_t count)
+    {
+        char text[INET6_ADDRSTRLEN];
+        inet_ntop(family, address, text, sizeof(text));
+        std::fprintf(stats_file, "%c,%lld,ecs,%s/%d,%llu\n", kind, start, text, prefix, (unsigned long long)count);
+    }
+};
+
+static void mergeWindow(aggregateWindow &into, const aggregateWindow &from)
+{
+    into.queries += from.queries;
+    into.responses += from.responses;
+    for (int i = 0; i < QTYPE_SLOTS; i++)
+    {
+        into.qtypes[i] += from.qtypes[i];
+    }
+    for (int i = 0; i < RCODE_SLOTS; i++)
+    {
+        into.rcodes[i] += from.rcodes[i];
+    }
+    for (int i = 0; i < SIZE_BUCKETS; i++)
+    {
+        into.sizes[i] += from.sizes[i];
+    }
+    for (int i = 0; i < PREFIX_SLOTS; i++)
+    {
+        if (from.prefix_keys[i] != 0)
+        {
+            addPrefix(into, from.prefix_keys[i], from.prefix_counts[i]);
+        }
+    }
+    into.prefix_overflow += from.prefix_overflow;
+    into.truncated += from.truncated;
+    for (int i = 0; i < EDNS_SIZE_BUCKETS; i++)
+    {
+        into.edns_sizes[i] += from.edns_sizes[i];
+    }
+    into.edns_do += from.edns_do;
+    subnetMerger merger = {into};
+    walkSubnets(from, merger);
+    into.ecs_overflow += from.ecs_overflow;
+}
+
+static void formatPrefix(uint64_t key, char *buffer, size_t size)
+{
+    int family = (int)(key >> 56);
+    uint8_t address[16] = {0};
+    int length = family == AF_INET ? 3 : 6;
+    for (int i = 0; i < length; i++)
+    {
+        address[i] = (uint8_t)(key >> (8 * (5 - i)));
+    }
+    char text[INET6_ADDRSTRLEN];
+    inet_ntop(family, address, text, sizeof(text));
+    snprintf(buffer, size, "%s/%d", text, family == AF_INET ? 24 : 48);
+}
+
+static void writeWindow(char kind, const aggregateWindow &window)
+{
+    long long start = (long long)window.start;
+    std::fprintf(stats_file, "%c,%lld,total,queries,%llu\n", kind, start, (unsigned long long)window.queries);
+    std::fprintf(stats_file, "%c,%lld,total,responses,%llu\n", kind, start, (unsigned long long)window.responses);
+    for (int i = 0; i < QTYPE_SLOTS; i++)
+    {
+        if (window.qtypes[i] != 0)
+        {
+            std::fprintf(stats_file, "%c,%lld,qtype,%d,%llu\n", kind, start, i, (unsigned long long)window.qtypes[i]);
+        }
+    }
+    for (int i = 0; i < RCODE_SLOTS; i++)
+    {
+        if (window.rcodes[i] != 0)
+        {
+            std::fprintf(stats_file, "%c,%lld,rcode,%d,%llu\n", kind, start, i, (unsigned long long)window.rcodes[i]);
+        }
+    }
+    for (int i = 0; i < SIZE_BUCKETS; i++)
+    {
+        if (window.sizes[i] != 0)
+        {
+            std::fprintf(stats_file, "%c,%lld,size,%u,%llu\n", kind, start, size_bucket_limits[i], (unsigned long long)window.sizes[i]);
+        }
+    }
+    for (int i = 0; i < PREFIX_SLOTS; i++)
+    {
+        if (window.prefix_keys[i] != 0)
+        {
+            char prefix[INET6_ADDRSTRLEN + 4];
+            formatPrefix(window.prefix_keys[i], prefix, sizeof(prefix));
+            std::fprintf(stats_file, "%c,%lld,client,%s,%llu\n", kind, start, prefix, (unsigned long long)window.prefix_counts[i]);
+        }
+    }
+    if (window.prefix_overflow != 0)
+    {
+        std::fprintf(stats_file, "%c,%lld,client,other,%llu\n", kind, start, (unsigned long long)window.prefix_overflow);
+    }
+    if (window.truncated != 0)
+    {
+        std::fprintf(stats_file, "%c,%lld,total,truncated,%llu\n", kind, start, (unsigned long long)window.truncated);
+    }
+    for (int i = 0; i < EDNS_SIZE_BUCKETS; i++)
+    {
+        if (window.edns_sizes[i] == 0)
+        {
+            continue;
+        }
+        if (i == 0)
+        {
+            std::fprintf(stats_file, "%c,%lld,edns,none,%llu\n", kind, start, (unsigned long long)window.edns_sizes[i]);
+        }
+        else
+        {
+            std::fprintf(stats_file, "%c,%lld,edns,%u,%llu\n", kind, start, edns_size_limits[i], (unsigned long long)window.edns_sizes[i]);
+        }
+    }
+    if (window.edns_do != 0)
+    {
+        std::fprintf(stats_file, "%c,%lld,edns,do,%llu\n", kind, start, (unsigned long long)window.edns_do);
+    }
+    subnetWriter writer = {kind, start};
+    walkSubnets(window, writer);
+    if (window.ecs_overflow != 0)
+    {
+        std::fprintf(stats_file, "%c,%lld,ecs,other,%llu\n", kind, start, (unsigned long long)window.ecs_overflow);
+    }
+}
+
+// closes the current second, folding it into its minute
+static void closeSecond()
+{
+    writeWindow('s', *current_second);
+    mergeWindow(*current_minute, *current_second);
+}
+
+static void advanceWindows(int64_t second)
+{
+    int64_t minute = second - second % 60;
+
+    if (current_second != nullptr)
+    {
+        closeSecond();
+        if (current_minute->start != minute)
+        {
+            writeWindow('m', *current_minute);
+            current_minute = nullptr;
+        }
+    }
+
+    current_second = &second_windows[second % SECOND_WINDOWS];
+    resetWindow(*current_second, second);
+    if (current_minute == nullptr)
+    {
+        current_minute = &minute_windows[(minute / 60) % MINUTE_WINDOWS];
+        resetWindow(*current_minute, minute);
+    }
+    std::fflush(stats_file);
+}
+
+bool initAggregates(const std::string &path, bool resume)
+{
+    stats_file = resume ? std::fopen(path.c_str(), "r+") : nullptr;
+    if (stats_file == nullptr)
+    {
+        resume = false;
+        stats_file = std::fopen(path.c_str(), "w");
+    }
+    if (stats_file == nullptr)
+    {
+        std::cerr << "Could not open statistics file " << path << std::endl;
+        return false;
+    }
+    for (int i = 0; i < SECOND_WINDOWS; i++)
+    {
+        second_windows[i].start = -1;
+    }
+    for (int i = 0; i < MINUTE_WINDOWS; i++)
+    {
+        minute_windows[i].start = -1;
+    }
+    if (!resume)
+    {
+        std::fprintf(stats_file, "window,start,metric,key,count\n");
+    }
+    return true;
+}
+
+// counts one message in the current second, which is already the right window
+static inline void countMessage(aggregateWindow &window, const dnsMessageInfo &info)
+{
+    if (info.response)
+    {
+        window.responses++;
+        window.rcodes[info.flags & 0x000F]++;
+        window.sizes[sizeBucket(info.size)]++;
+        if (info.flags & 0x0200)
+        {
+            window.truncated++;
+        }
+    }
+    else
+    {
+        window.queries++;
+        // what clients advertise decides truncation, the subnet is the client behind a forwarder
+        window.edns_sizes[ednsBucket(info.edns_size)]++;
+        window.edns_do += info.edns_do;
+        if (info.ecs_family != 0)
+        {
+            addSubnet(window, info.ecs_family, info.ecs_address, info.ecs_prefix, 1);
+        }
+    }
+    window.qtypes[info.qtype < QTYPE_SLOTS ? info.qtype : QTYPE_SLOTS - 1]++;
+    addPrefix(window, prefixKey(info), 1);
+}
+
+void recordMessage(const dnsMessageInfo &info)
+{
+    recordMessages(&info, 1);
+}
+
+void recordMessages(const dnsMessageInfo *infos, size_t count)
+{
+    if (stats_file == nullptr || count == 0)
+    {
+        return;
+    }
+
+    // a batch normally falls into one second, the window only changes at its boundary
+    int64_t window_start = current_second != nullptr ? current_second->start : INT64_MIN;
+    for (size_t i = 0; i < count; i++)
+    {
+        // late packets are counted in the current window instead of reopening an old one
+        if (infos[i].ts.tv_sec > window_start)
+        {
+            advanceWindows(infos[i].ts.tv_sec);
+            window_start = current_second->start;
+        }
+        countMessage(*current_second, infos[i]);
+    }
+}
+
+void closeAggregates()
+{
+    if (stats_file == nullptr)
+    {
+        return;
+    }
+    if (current_second != nullptr)
+    {
+        closeSecond();
+        writeWindow('m', *current_minute);
+        current_second = nullptr;
+        current_minute = nullptr;
+    }
+    std::fclose(stats_file);
+    stats_file = nullptr;
+}
+
+void saveAggregates(std::string &state)
+{
+    state.clear();
+    if (stats_file == nullptr)
+    {
+        return;
+    }
+
+    std::fflush(stats_file);
+    int64_t length = std::ftell(stats_file);
+    state.append((const char *)&length, sizeof(length));
+    // both current windows or none
+    if (current_second != nullptr)
+    {
+        state.append((const char *)current_second, sizeof(aggregateWindow));
+        state.append((const char *)current_minute, sizeof(aggregateWindow));
+    }
+}
+
+bool restoreAggregates(const std::string &state)
+{
+    if (stats_file == nullptr)
+    {
+        return true;
+    }
+
+    // the statistics were not collected before the checkpoint, start the file again
+    if (state.empty())
+    {
+        if (ftruncate(fileno(stats_file), 0) != 0)
+        {
+            return false;
+        }
+        std::rewind(stats_file);
+        std::fprintf(stats_file, "window,start,metric,key,count\n");
+        return true;
+    }
+
+    int64_t length;
+    if (state.size() != sizeof(length) && state.size() != sizeof(length) + 2 * sizeof(aggregateWindow))
+    {
+        return false;
+    }
+    std::memcpy(&length, state.data(), sizeof(length));
+    if (ftruncate(fileno(stats_file), length) != 0 || std::fseek(stats_file, length, SEEK_SET) != 0)
+    {
+        return false;
+    }
+
+    current_second = nullptr;
+    current_minute = nullptr;
+    if (state.size() > sizeof(length))
+    {
+        aggregateWindow second;
+        aggregateWindow minute;
+        std::memcpy(&second, state.data() + sizeof(length), sizeof(second));
+        std::memcpy(&minute, state.data() + sizeof(length) + sizeof(second), sizeof(minute));
+        current_second = &second_windows[second.start % SECOND_WINDOWS];
+        *current_second = second;
+        current_minute = &minute_windows[(minute.start / 60) % MINUTE_WINDOWS];
+        *current_minute = minute;
+    }
+    return true;
+}
@@ -0,0 +1,90 @@
+#ifndef AGGREGATES_H
+#define AGGREGATES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/time.h>
+
+#define QTYPE_SLOTS 256    // qtypes above 255 are counted in the last slot
+#define RCODE_SLOTS 16
+#define SIZE_BUCKETS 8     // response sizes, upper bounds in size_bucket_limits
+#define PREFIX_SLOTS 1024  // client prefixes tracked per window, the rest is counted as overflow
+#define SECOND_WINDOWS 60
+#define MINUTE_WINDOWS 60
+#define QUESTION_DOMAIN_LENGTH 64 // registered domain kept for the detector, longer ones are cut
+#define EDNS_SIZE_BUCKETS 8 // advertised UDP payload sizes of queries, bucket 0 is no EDNS
+#define ECS_TRIE_NODES 2048 // client subnet trie nodes per window, at least 1024 subnets, the rest is overflow
+
+// Decoded summary of one DNS message, shared by the aggregation and analysis stages
+struct dnsMessageInfo {
+    struct timeval ts;
+    int family;         // AF_INET or AF_INET6
+    uint8_t client[16]; // the side that sent the query
+    uint16_t qtype;     // type of the first question, 0 when there is none
+    uint16_t flags;     // DNS header flags in host order
+    uint16_t size;      // size of the DNS message
+    bool response;
+    uint64_t qname_hash;  // first question name, 0 when the detector is off or there is no question
+    uint64_t domain_hash; // its registered domain
+    char domain[QUESTION_DOMAIN_LENGTH];
+    uint16_t edns_size;      // UDP payload size of the OPT record, 0 without EDNS
+    bool edns_do;            // DNSSEC OK bit
+    uint8_t ecs_family;      // AF_INET or AF_INET6 of the client subnet option, 0 without one
+    uint8_t ecs_prefix;      // its source prefix length
+    uint8_t ecs_address[16]; // bits past the prefix are zero
+};
+
+// Node of the path-compressed binary trie of client subnets, nodes 0 and 1 are the IPv4 and IPv6 roots
+struct ecsTrieNode {
+    uint8_t key[16];   // subnet address, bits past length are zero
+    uint8_t length;    // prefix length
+    uint16_t child[2]; // by the bit after the prefix, 0 = none as a root is never a child
+    uint64_t count;    // queries with exactly this subnet, 0 for branching nodes
+};
+
+// Counters of one second or one minute
+struct aggregateWindow {
+    int64_t start; // epoch seconds, -1 for an unused window
+    uint64_t queries;
+    uint64_t responses;
+    uint64_t qtypes[QTYPE_SLOTS];
+    uint64_t rcodes[RCODE_SLOTS];
+    uint64_t sizes[SIZE_BUCKETS];
+    uint64_t prefix_keys[PREFIX_SLOTS]; // family in the top byte, /24 or /48 prefix below, 0 = empty
+    uint64_t prefix_counts[PREFIX_SLOTS];
+    uint64_t prefix_overflow;
+    uint64_t truncated;                     // responses with the TC bit
+    uint64_t edns_sizes[EDNS_SIZE_BUCKETS]; // queries by advertised size, upper bounds in edns_size_limits
+    uint64_t edns_do;                       // queries with the DO bit
+    ecsTrieNode ecs_nodes[ECS_TRIE_NODES];
+    uint16_t ecs_node_count;
+    uint64_t ecs_overflow;
+};
+
+/**
+ * @brief Opens the CSV file the closed windows are written to
+ *
+ * Every row is "window,start,metric,key,count", window is s (second) or m (minute)
+ * and metric one of total, qtype, rcode, size, client, edns, ecs.
+ *
+ * @param resume keep the existing file, restoreAggregates cuts it back to the checkpoint
+ */
+bool initAggregates(const std::string &path, bool resume = false);
+
+// Adds one message to the current windows, windows are advanced by the packet timestamps
+void recordMessage(const dnsMessageInfo &info);
+
+// Adds the messages of one batch
+void recordMessages(const dnsMessageInfo *infos, size_t count);
+
+// Writes the windows that are still open and closes the file
+void closeAggregates();
+
+// Serializes the open windows and the length of the CSV file written so far
+void saveAggregates(std::string &state);
+
+// Restores the windows saved by saveAggregates and truncates the CSV file to the saved length
+bool restoreAggregates(const std::string &state);
+
+#endif
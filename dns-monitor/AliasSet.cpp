@@ -0,0 +1,70 @@
+#include "AliasSet.h"
+#include "Dedup.h"
+
+#include <cstring>
+
+#define ALIAS_HASH_SEED 'A'
+
+static void insertSlot(uint64_t *slots, uint64_t mask, uint64_t hash)
+{
+    uint64_t index = (hash ^ (hash >> 32)) & mask;
+    while (slots[index] != 0)
+    {
+        index = (index + 1) & mask;
+    }
+    slots[index] = hash;
+}
+
+static void growSet(aliasSet &set)
+{
+    uint64_t slot_count = set.slots == nullptr ? ALIAS_SET_INITIAL_SLOTS : (set.mask + 1) * 2;
+    uint64_t *slots = new uint64_t[slot_count]();
+    for (uint64_t i = 0; set.slots != nullptr && i <= set.mask; i++)
+    {
+        if (set.slots[i] != 0)
+        {
+            insertSlot(slots, slot_count - 1, set.slots[i]);
+        }
+    }
+    delete[] set.slots;
+    set.slots = slots;
+    set.mask = slot_count - 1;
+}
+
+bool aliasInsert(aliasSet &set, const char *line, size_t length)
+{
+    if (set.slots == nullptr || (set.count + 1) * 2 > set.mask + 1)
+    {
+        growSet(set);
+    }
+
+    uint64_t hash = dedupHash(line, length, ALIAS_HASH_SEED);
+    if (hash == 0)
+    {
+        hash = 1;
+    }
+    uint64_t index = (hash ^ (hash >> 32)) & set.mask;
+    while (set.slots[index] != 0)
+    {
+        if (set.slots[index] == hash)
+        {
+            return false;
+        }
+        index = (index + 1) & set.mask;
+    }
+
+    set.slots[index] = hash;
+    set.count++;
+    set.lines.append(line, length);
+    set.lines += '\n';
+    return true;
+}
+
+void clearAliases(aliasSet &set)
+{
+    delete[] set.slots;
+    set.slots = nullptr;
+    set.mask = 0;
+    set.count = 0;
+    set.lines.clear();
+}
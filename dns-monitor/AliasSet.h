@@ -0,0 +1,33 @@
+#ifndef ALIASSET_H
+#define ALIASSET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#define ALIAS_SET_INITIAL_SLOTS 1024 // power of two, doubled once the set is half full
+
+/*
+ * In-memory set of the "alias ip" lines already written to the translations file.
+ * Lookups hash the line (dedupHash) into an open addressing table of 64-bit hashes,
+ * so a line that was seen before costs no allocation. New lines are appended to one
+ * text buffer, which checkpoints save and restore.
+ */
+
+struct aliasSet {
+    uint64_t *slots;   // line hashes, 0 = empty
+    uint64_t mask;
+    uint64_t count;
+    std::string lines; // every inserted line, each terminated by '\n'
+};
+
+/**
+ * @brief Adds a line
+ *
+ * @return true when the line was not in the set yet
+ */
+bool aliasInsert(aliasSet &set, const char *line, size_t length);
+
+void clearAliases(aliasSet &set);
+
+#endif
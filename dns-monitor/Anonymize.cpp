@@ -0,0 +1,290 @@
+#include "Anonymize.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <sys/socket.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <wmmintrin.h>
+#define ANONYMIZE_AESNI
+#endif
+
+#define AES_ROUNDS 10
+#define AESNI_LANES 8 // blocks in flight, enough to hide the latency of aesenc
+
+struct anonymizeEntry {
+    uint8_t family; // 0 = empty
+    uint8_t key[16];
+    uint8_t value[16]; // pseudonym, or the one-time pad of the prefix bits in the prefix memo
+};
+
+static bool active = false;
+static uint8_t sbox[256];
+static uint32_t mix_table[256]; // column of MixColumns(S(x), 0, 0, 0), stored little endian
+static uint8_t round_keys[AES_ROUNDS + 1][16];
+static uint8_t pad[16];
+static anonymizeEntry *address_memo = nullptr;
+static anonymizeEntry *prefix_memo = nullptr;
+static void (*encryptBlocks)(uint8_t (*blocks)[16], size_t count) = nullptr;
+
+static inline uint8_t rotateByte(uint8_t value, int shift)
+{
+    return (uint8_t)((value << shift) | (value >> (8 - shift)));
+}
+
+static inline uint8_t xtime(uint8_t value)
+{
+    return (uint8_t)((value << 1) ^ ((value & 0x80) ? 0x1b : 0));
+}
+
+// walks the multiplicative group with generator 3 and its inverse 1/3 together
+static void buildSbox()
+{
+    uint8_t p = 1, q = 1;
+    do
+    {
+        p = p ^ xtime(p);
+        q ^= q << 1;
+        q ^= q << 2;
+        q ^= q << 4;
+        if (q & 0x80)
+        {
+            q ^= 0x09;
+        }
+        sbox[p] = q ^ rotateByte(q, 1) ^ rotateByte(q, 2) ^ rotateByte(q, 3) ^ rotateByte(q, 4) ^ 0x63;
+    } while (p != 1);
+    sbox[0] = 0x63;
+
+    for (int i = 0; i < 256; i++)
+    {
+        uint8_t value = sbox[i];
+        uint8_t twice = xtime(value);
+        mix_table[i] = twice | (uint32_t)value << 8 | (uint32_t)value << 16 | (uint32_t)(twice ^ value) << 24;
+    }
+}
+
+static void expandKey(const uint8_t *key)
+{
+    std::memcpy(round_keys[0], key, 16);
+    uint8_t rcon = 1;
+    for (int i = 1; i <= AES_ROUNDS; i++)
+    {
+        const uint8_t *last = round_keys[i - 1];
+        uint8_t word[4] = {(uint8_t)(sbox[last[13]] ^ rcon), sbox[last[14]], sbox[last[15]], sbox[last[12]]};
+        for (int j = 0; j < 16; j++)
+        {
+            round_keys[i][j] = last[j] ^ (j < 4 ? word[j] : round_keys[i][j - 4]);
+        }
+        rcon = xtime(rcon);
+    }
+}
+
+static inline uint32_t rotateWord(uint32_t value, int shift)
+{
+    return shift == 0 ? value : (value << shift) | (value >> (32 - shift));
+}
+
+// one round without AES-NI: SubBytes, ShiftRows and MixColumns of a column in four table lookups
+static void encryptSoftware(uint8_t (*blocks)[16], size_t count)
+{
+    for (size_t n = 0; n < count; n++)
+    {
+        uint8_t *state = blocks[n];
+        for (int j = 0; j < 16; j++)
+        {
+            state[j] ^= round_keys[0][j];
+        }
+        for (int round = 1; round < AES_ROUNDS; round++)
+        {
+            uint32_t columns[4];
+            for (int column = 0; column < 4; column++)
+            {
+                uint32_t key;
+                std::memcpy(&key, round_keys[round] + column * 4, 4);
+                // the state is stored column by column, row r comes from column + r
+                columns[column] = key ^ mix_table[state[column * 4]] ^
+                                  rotateWord(mix_table[state[((column + 1) & 3) * 4 + 1]], 8) ^
+                                  rotateWord(mix_table[state[((column + 2) & 3) * 4 + 2]], 16) ^
+                                  rotateWord(mix_table[state[((column + 3) & 3) * 4 + 3]], 24);
+            }
+            std::memcpy(state, columns, 16);
+        }
+        uint8_t last[16];
+        for (int column = 0; column < 4; column++)
+        {
+            for (int row = 0; row < 4; row++)
+            {
+                last[column * 4 + row] = sbox[state[((column + row) & 3) * 4 + row]] ^ round_keys[AES_ROUNDS][column * 4 + row];
+            }
+        }
+        std::memcpy(state, last, 16);
+    }
+}
+
+#ifdef ANONYMIZE_AESNI
+__attribute__((target("aes,sse2"))) static void encryptAesni(uint8_t (*blocks)[16], size_t count)
+{
+    __m128i keys[AES_ROUNDS + 1];
+    for (int i = 0; i <= AES_ROUNDS; i++)
+    {
+        keys[i] = _mm_loadu_si128((const __m128i *)round_keys[i]);
+    }
+
+    // full groups keep all lanes in registers, the tail goes one block at a time
+    size_t n = 0;
+    for (; n + AESNI_LANES <= count; n += AESNI_LANES)
+    {
+        __m128i state[AESNI_LANES];
+        for (int i = 0; i < AESNI_LANES; i++)
+        {
+            state[i] = _mm_xor_si128(_mm_loadu_si128((const __m128i *)blocks[n + i]), keys[0]);
+        }
+        for (int round = 1; round < AES_ROUNDS; round++)
+        {
+            for (int i = 0; i < AESNI_LANES; i++)
+            {
+                state[i] = _mm_aesenc_si128(state[i], keys[round]);
+            }
+        }
+        for (int i = 0; i < AESNI_LANES; i++)
+        {
+            _mm_storeu_si128((__m128i *)blocks[n + i], _mm_aesenclast_si128(state[i], keys[AES_ROUNDS]));
+        }
+    }
+    for (; n < count; n++)
+    {
+        __m128i state = _mm_xor_si128(_mm_loadu_si128((const __m128i *)blocks[n]), keys[0]);
+        for (int round = 1; round < AES_ROUNDS; round++)
+        {
+            state = _mm_aesenc_si128(state, keys[round]);
+        }
+        _mm_storeu_si128((__m128i *)blocks[n], _mm_aesenclast_si128(state, keys[AES_ROUNDS]));
+    }
+}
+#endif
+
+// fills the pad bits of positions [from, to): the top bit of AES(first bit_index address bits | pad)
+static void computePad(const uint8_t *address, unsigned from, unsigned to, uint8_t *one_time_pad)
+{
+    uint8_t blocks[128][16];
+    // whole address bytes are copied into the template as the position passes them
+    uint8_t input[16];
+    std::memcpy(input, pad, 16);
+    std::memcpy(input, address, from / 8);
+    for (unsigned bit = from; bit < to; bit++)
+    {
+        unsigned byte = bit / 8;
+        uint8_t mask = (uint8_t)(0xff00 >> (bit % 8));
+        std::memcpy(blocks[bit - from], input, 16);
+        blocks[bit - from][byte] = (address[byte] & mask) | (pad[byte] & ~mask);
+        if (bit % 8 == 7)
+        {
+            input[byte] = address[byte];
+        }
+    }
+
+    encryptBlocks(blocks, to - from);
+
+    for (unsigned bit = from; bit < to; bit++)
+    {
+        one_time_pad[bit / 8] |= (blocks[bit - from][0] >> 7) << (7 - bit % 8);
+    }
+}
+
+static inline anonymizeEntry &memoEntry(anonymizeEntry *memo, int family, const uint8_t *key, size_t length)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL ^ (uint64_t)family;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ key[i]) * 0x100000001b3ULL;
+    }
+    return memo[(hash ^ (hash >> 29)) & (ANONYMIZE_CACHE_SIZE - 1)];
+}
+
+static inline bool memoHit(const anonymizeEntry &entry, int family, const uint8_t *key, size_t length)
+{
+    return entry.family == family && std::memcmp(entry.key, key, length) == 0;
+}
+
+bool initAnonymizer(const std::string &key_path)
+{
+    uint8_t key[ANONYMIZE_KEY_SIZE];
+    FILE *file = std::fopen(key_path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        std::cerr << "Could not open anonymization key " << key_path << std::endl;
+        return false;
+    }
+    size_t read = std::fread(key, 1, sizeof(key), file);
+    std::fclose(file);
+    if (read != sizeof(key))
+    {
+        std::cerr << "Anonymization key " << key_path << " must have " << ANONYMIZE_KEY_SIZE << " bytes" << std::endl;
+        return false;
+    }
+
+    buildSbox();
+    expandKey(key);
+    encryptBlocks = encryptSoftware;
+#ifdef ANONYMIZE_AESNI
+    if (__builtin_cpu_supports("aes"))
+    {
+        encryptBlocks = encryptAesni;
+    }
+#endif
+
+    // the pad is the encrypted second half of the key
+    uint8_t blocks[1][16];
+    std::memcpy(blocks[0], key + 16, 16);
+    encryptBlocks(blocks, 1);
+    std::memcpy(pad, blocks[0], 16);
+
+    address_memo = new anonymizeEntry[ANONYMIZE_CACHE_SIZE]();
+    prefix_memo = new anonymizeEntry[ANONYMIZE_CACHE_SIZE]();
+    active = true;
+    std::cerr << "Anonymizing addresses with " << (encryptBlocks == encryptSoftware ? "software AES" : "AES-NI") << std::endl;
+    return true;
+}
+
+bool anonymizerActive()
+{
+    return active;
+}
+
+void anonymizeAddress(int family, uint8_t *address)
+{
+    unsigned bits = family == AF_INET ? 32 : 128;
+    unsigned prefix_bits = family == AF_INET ? ANONYMIZE_PREFIX_IPV4 : ANONYMIZE_PREFIX_IPV6;
+
+    anonymizeEntry &entry = memoEntry(address_memo, family, address, bits / 8);
+    if (memoHit(entry, family, address, bits / 8))
+    {
+        std::memcpy(address, entry.value, bits / 8);
+        return;
+    }
+
+    // the pad of the prefix bits only depends on the prefix
+    uint8_t one_time_pad[16] = {0};
+    anonymizeEntry &prefix = memoEntry(prefix_memo, family, address, prefix_bits / 8);
+    if (memoHit(prefix, family, address, prefix_bits / 8))
+    {
+        std::memcpy(one_time_pad, prefix.value, prefix_bits / 8);
+    }
+    else
+    {
+        computePad(address, 0, prefix_bits, one_time_pad);
+        prefix.family = family;
+        std::memcpy(prefix.key, address, prefix_bits / 8);
+        std::memcpy(prefix.value, one_time_pad, prefix_bits / 8);
+    }
+    computePad(address, prefix_bits, bits, one_time_pad);
+
+    entry.family = family;
+    std::memcpy(entry.key, address, bits / 8);
+    for (unsigned i = 0; i < bits / 8; i++)
+    {
+        address[i] ^= one_time_pad[i];
+    }
+    std::memcpy(entry.value, address, bits / 8);
+}
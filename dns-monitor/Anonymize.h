@@ -0,0 +1,42 @@
+#ifndef ANONYMIZE_H
+#define ANONYMIZE_H
+
+#include <cstdint>
+#include <string>
+
+#define ANONYMIZE_KEY_SIZE 32     // AES-128 key followed by the secret the pad is derived from
+#define ANONYMIZE_CACHE_SIZE 8192 // entries of the address and the prefix memo, power of two
+#define ANONYMIZE_PREFIX_IPV4 24  // prefix lengths kept in the prefix memo
+#define ANONYMIZE_PREFIX_IPV6 64
+
+/*
+ * Prefix-preserving pseudonymization of IP addresses (Crypto-PAn). Bit i of the
+ * address is flipped by the top bit of AES(first i bits of the address, padded with
+ * a secret pad), so two addresses sharing a k-bit prefix get pseudonyms sharing a
+ * k-bit prefix and subnet level analysis still works on the anonymized output.
+ * The result is the same as the reference implementation for the same 32-byte key.
+ *
+ * The blocks of one address do not depend on each other, with AES-NI they are
+ * encrypted eight at a time. Whole addresses and their /24 or /64 prefixes are
+ * remembered in direct-mapped memos, so a repeated client costs one lookup and a
+ * new host in a known network only the bits after the prefix.
+ */
+
+/**
+ * @brief Loads the key and enables anonymization
+ *
+ * @param key_path file with ANONYMIZE_KEY_SIZE random bytes
+ * @return false if the key could not be read
+ */
+bool initAnonymizer(const std::string &key_path);
+
+bool anonymizerActive();
+
+/**
+ * @brief Replaces an address with its pseudonym in place
+ *
+ * @param family AF_INET (4 bytes) or AF_INET6 (16 bytes)
+ */
+void anonymizeAddress(int family, uint8_t *address);
+
+#endif
@@ -0,0 +1,259 @@
+#include "AttackDetector.h"
+#include "Format.h"
+
+#include <iostream>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <arpa/inet.h>
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+struct detectorEntry {
+    uint64_t key;        // 0 = empty
+    int64_t updated;     // microseconds, time the counters were decayed to
+    int64_t quiet_until[2]; // no further alert of the kind before this time
+    double messages;
+    double responses;
+    double nxdomain;
+    double servfail;
+    double unique;       // messages whose question name was not seen recently
+    char name[QUESTION_DOMAIN_LENGTH];
+};
+
+enum ALERT_KIND
+{
+    ALERT_ERROR_BURST,
+    ALERT_RANDOM_SUBDOMAIN
+};
+
+static const char *alert_names[2] = {"error-burst", "random-subdomain"};
+
+struct detectorSet {
+    detectorEntry ways[DETECTOR_WAYS];
+};
+
+static detectorSet *domain_table = nullptr;
+static detectorSet *client_table = nullptr;
+static uint64_t *recent_names = nullptr;
+static FILE *alert_file = nullptr;
+static uint64_t alert_count = 0;
+
+bool initDetector(const std::string &path)
+{
+    alert_file = path == "-" ? stderr : std::fopen(path.c_str(), "a");
+    if (alert_file == nullptr)
+    {
+        std::cerr << "Could not open alert file " << path << std::endl;
+        return false;
+    }
+    domain_table = new detectorSet[DETECTOR_SETS]();
+    client_table = new detectorSet[DETECTOR_SETS]();
+    recent_names = new uint64_t[DETECTOR_RECENT_NAMES]();
+    return true;
+}
+
+bool detectorActive()
+{
+    return alert_file != nullptr;
+}
+
+static uint64_t nameHash(const char *name, size_t length)
+{
+    uint64_t hash = FNV_OFFSET;
+    for (size_t i = 0; i < length; i++)
+    {
+        unsigned char c = name[i];
+        hash = (hash ^ ((c >= 'A' && c <= 'Z') ? c | 0x20 : c)) * FNV_PRIME;
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+// start of the registered domain: the last two labels, three under short second levels like co.uk
+static size_t registeredDomain(const std::string &name)
+{
+    size_t length = name.size();
+    if (length > 0 && name[length - 1] == '.')
+    {
+        length--;
+    }
+    size_t tld = name.rfind('.', length - 1);
+    if (tld == std::string::npos || tld == 0)
+    {
+        return 0;
+    }
+    size_t second = name.rfind('.', tld - 1);
+    if (second == std::string::npos)
+    {
+        return 0;
+    }
+    if (length - tld - 1 == 2 && tld - second - 1 <= 3)
+    {
+        size_t third = second == 0 ? std::string::npos : name.rfind('.', second - 1);
+        return third == std::string::npos ? 0 : third + 1;
+    }
+    return second + 1;
+}
+
+void describeQuestion(dnsMessageInfo &info, const std::string &name)
+{
+    size_t start = registeredDomain(name);
+    size_t length = name.size() - start;
+    if (length > 0 && name[name.size() - 1] == '.')
+    {
+        length--;
+    }
+    info.qname_hash = nameHash(name.data(), name.size());
+    info.domain_hash = nameHash(name.data() + start, length);
+    if (length >= QUESTION_DOMAIN_LENGTH)
+    {
+        length = QUESTION_DOMAIN_LENGTH - 1;
+    }
+    std::memcpy(info.domain, name.data() + start, length);
+    info.domain[length] = '\0';
+}
+
+static inline int64_t messageTime(const dnsMessageInfo &info)
+{
+    return (int64_t)info.ts.tv_sec * 1000000 + info.ts.tv_usec;
+}
+
+static void decayEntry(detectorEntry &entry, int64_t now)
+{
+    // late packets are counted without decaying back in time
+    if (now <= entry.updated)
+    {
+        return;
+    }
+    double factor = std::exp2(-(double)(now - entry.updated) / (DETECTOR_HALF_LIFE_S * 1e6));
+    entry.messages *= factor;
+    entry.responses *= factor;
+    entry.nxdomain *= factor;
+    entry.servfail *= factor;
+    entry.unique *= factor;
+    entry.updated = now;
+}
+
+// entry of the key, a new one replaces the entry of the set with the lowest decayed activity
+static detectorEntry &findEntry(detectorSet *table, uint64_t key, int64_t now, bool &created)
+{
+    detectorSet &set = table[(key ^ (key >> 29)) & (DETECTOR_SETS - 1)];
+    detectorEntry *victim = &set.ways[0];
+    for (int way = 0; way < DETECTOR_WAYS; way++)
+    {
+        detectorEntry &entry = set.ways[way];
+        if (entry.key == key)
+        {
+            decayEntry(entry, now);
+            created = false;
+            return entry;
+        }
+        // stale entries are compared by what is left of their activity now
+        if (entry.key != 0)
+        {
+            decayEntry(entry, now);
+        }
+        if (victim->key != 0 && (entry.key == 0 || entry.messages < victim->messages))
+        {
+            victim = &entry;
+        }
+    }
+
+    std::memset(victim, 0, sizeof(*victim));
+    victim->key = key;
+    victim->updated = now;
+    created = true;
+    return *victim;
+}
+
+static void alert(detectorEntry &entry, const dnsMessageInfo &info, ALERT_KIND kind, const char *subject)
+{
+    if (messageTime(info) < entry.quiet_until[kind])
+    {
+        return;
+    }
+    char timestamp[TIMESTAMP_LENGTH + 1];
+    timestamp[formatTimestamp(timestamp, info.ts)] = '\0';
+    std::fprintf(alert_file, "%s ALERT %s %s %s messages=%.0f responses=%.0f nxdomain=%.0f servfail=%.0f unique=%.0f\n",
+                 timestamp, alert_names[kind], subject, entry.name, entry.messages, entry.responses, entry.nxdomain, entry.servfail, entry.unique);
+    std::fflush(alert_file);
+    entry.quiet_until[kind] = messageTime(info) + (int64_t)DETECTOR_ALERT_HOLD_S * 1000000;
+    alert_count++;
+}
+
+static void updateEntry(detectorEntry &entry, const dnsMessageInfo &info, bool unique, const char *subject)
+{
+    entry.messages += 1;
+    entry.unique += unique;
+    if (info.response)
+    {
+        entry.responses += 1;
+        entry.nxdomain += (info.flags & 0x000F) == 3;
+        entry.servfail += (info.flags & 0x000F) == 2;
+    }
+
+    if (entry.responses >= DETECTOR_MIN_RESPONSES && entry.nxdomain + entry.servfail >= DETECTOR_ERROR_RATIO * entry.responses)
+    {
+        alert(entry, info, ALERT_ERROR_BURST, subject);
+    }
+    if (entry.unique >= DETECTOR_MIN_UNIQUE && entry.unique >= DETECTOR_UNIQUE_RATIO * entry.messages)
+    {
+        alert(entry, info, ALERT_RANDOM_SUBDOMAIN, subject);
+    }
+}
+
+void observeMessages(const dnsMessageInfo *infos, size_t count)
+{
+    if (alert_file == nullptr)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const dnsMessageInfo &info = infos[i];
+        // messages without a question carry neither a domain nor a name
+        if (info.qname_hash == 0)
+        {
+            continue;
+        }
+        int64_t now = messageTime(info);
+
+        uint64_t &recent = recent_names[info.qname_hash & (DETECTOR_RECENT_NAMES - 1)];
+        bool unique = recent != info.qname_hash;
+        recent = info.qname_hash;
+
+        bool created;
+        detectorEntry &domain = findEntry(domain_table, info.domain_hash, now, created);
+        if (created)
+        {
+            std::strcpy(domain.name, info.domain);
+        }
+        updateEntry(domain, info, unique, "domain");
+
+        int length = info.family == AF_INET ? 4 : 16;
+        uint64_t client_key = nameHash((const char *)info.client, length) ^ (uint64_t)info.family;
+        detectorEntry &client = findEntry(client_table, client_key == 0 ? 1 : client_key, now, created);
+        if (created)
+        {
+            size_t text = info.family == AF_INET ? formatIPv4(client.name, info.client) : formatIPv6(client.name, info.client);
+            client.name[text] = '\0';
+        }
+        updateEntry(client, info, unique, "client");
+    }
+}
+
+uint64_t detectorAlerts()
+{
+    return alert_count;
+}
+
+void closeDetector()
+{
+    if (alert_file != nullptr && alert_file != stderr)
+    {
+        std::fclose(alert_file);
+    }
+    alert_file = nullptr;
+}
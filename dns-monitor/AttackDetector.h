@@ -0,0 +1,51 @@
+#ifndef ATTACKDETECTOR_H
+#define ATTACKDETECTOR_H
+
+#include "Aggregates.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#define DETECTOR_SETS 1024            // sets per table, each holds DETECTOR_WAYS domains or clients
+#define DETECTOR_WAYS 4
+#define DETECTOR_RECENT_NAMES 65536   // recently seen question names, for the unique name rate
+#define DETECTOR_HALF_LIFE_S 10       // counters lose half their value in this time
+#define DETECTOR_MIN_RESPONSES 20     // decayed responses before the error ratio is judged
+#define DETECTOR_ERROR_RATIO 0.5      // NXDOMAIN + SERVFAIL share of responses that raises an alert
+#define DETECTOR_MIN_UNIQUE 50        // decayed never-seen names before the unique rate is judged
+#define DETECTOR_UNIQUE_RATIO 0.25    // share of messages with a never-seen name that raises an alert
+#define DETECTOR_ALERT_HOLD_S 60      // an entry raises the same kind of alert at most this often
+
+/*
+ * Detector of NXDOMAIN/SERVFAIL bursts and random subdomain (water torture) attacks.
+ * Every message updates the entry of its registered domain and of its client. Entries
+ * hold exponentially decayed counts of messages, responses, NXDOMAIN, SERVFAIL and of
+ * question names not seen recently, so they approximate rates over the last
+ * DETECTOR_HALF_LIFE_S seconds without any per-window state. Both tables have a fixed
+ * size; a new domain or client replaces the entry with the lowest decayed activity in
+ * its set, so heavy hitters stay and memory is bounded.
+ */
+
+/**
+ * @brief Enables the detector
+ *
+ * @param path file the alerts are appended to, "-" for stderr
+ */
+bool initDetector(const std::string &path);
+
+bool detectorActive();
+
+/**
+ * @brief Fills the question fields of info used by the detector from the first question name
+ */
+void describeQuestion(dnsMessageInfo &info, const std::string &name);
+
+// Updates the domain and client entries with the messages of one batch
+void observeMessages(const dnsMessageInfo *infos, size_t count);
+
+uint64_t detectorAlerts();
+
+void closeDetector();
+
+#endif
@@ -0,0 +1,77 @@
+#include "Batch.h"
+
+#include <cstring>
+
+static batchHandler batch_handler = nullptr;
+static u_char *batch_user = nullptr;
+
+static packetBatch pending;
+alignas(64) static u_char pending_data[BATCH_DATA_SIZE];
+static size_t pending_used = 0;
+
+// set while a batch is processed, a flush from inside the handler must not start another one
+static volatile bool batch_running = false;
+
+void initBatching(batchHandler handler, u_char *user)
+{
+    batch_handler = handler;
+    batch_user = user;
+    pending.count = 0;
+    pending_used = 0;
+}
+
+void runBatch(const packetBatch &batch)
+{
+    if (batch.count == 0 || batch_running)
+    {
+        return;
+    }
+    flushBatch();
+    batch_running = true;
+    batch_handler(batch, batch_user);
+    batch_running = false;
+}
+
+void flushBatch()
+{
+    if (pending.count == 0 || batch_running)
+    {
+        return;
+    }
+    batch_running = true;
+    batch_handler(pending, batch_user);
+    batch_running = false;
+    pending.count = 0;
+    pending_used = 0;
+}
+
+void batchPacket(u_char *, const struct pcap_pkthdr *header, const u_char *packet)
+{
+    if (pending_used + header->caplen > BATCH_DATA_SIZE)
+    {
+        flushBatch();
+    }
+
+    // larger than the whole copy area, the packet is processed on its own while its buffer is valid
+    if (header->caplen > BATCH_DATA_SIZE)
+    {
+        packetBatch single;
+        single.count = 1;
+        single.headers[0] = *header;
+        single.packets[0] = packet;
+        runBatch(single);
+        return;
+    }
+
+    u_char *copy = pending_data + pending_used;
+    std::memcpy(copy, packet, header->caplen);
+    // keep every copy 64 byte aligned so the headers start at the beginning of a cache line
+    pending_used = (pending_used + header->caplen + 63) & ~(size_t)63;
+
+    pending.headers[pending.count] = *header;
+    pending.packets[pending.count] = copy;
+    if (++pending.count == PACKET_BATCH)
+    {
+        flushBatch();
+    }
+}
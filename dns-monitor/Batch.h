@@ -0,0 +1,42 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <pcap.h>
+#include <cstddef>
+
+#define PACKET_BATCH 64         // packets processed together, same as the capture batches
+#define BATCH_PREFETCH 4        // how many packets ahead the headers are prefetched
+#define BATCH_DATA_SIZE 262144  // copies of packets whose buffers do not outlive the callback
+
+/*
+ * Packets are processed in batches: every decode phase runs over the whole batch before
+ * the next one starts, so the loops stay small and predictable and the headers of the
+ * following packets can be prefetched while the current one is decoded.
+ *
+ * Backends that own their buffers until the batch is done (AF_XDP) hand over arrays of
+ * pointers with runBatch. libpcap reuses its buffer between callbacks, so its packets go
+ * through batchPacket, which copies them and runs the batch when it is full. Capture
+ * loops call flushBatch at the end of every round so no packet waits for a full batch.
+ */
+
+struct packetBatch {
+    size_t count;
+    struct pcap_pkthdr headers[PACKET_BATCH];
+    const u_char *packets[PACKET_BATCH];
+};
+
+typedef void (*batchHandler)(const packetBatch &batch, u_char *user);
+
+// Sets the function that processes complete batches
+void initBatching(batchHandler handler, u_char *user);
+
+// pcap_handler that copies the packet into the pending batch
+void batchPacket(u_char *user, const struct pcap_pkthdr *header, const u_char *packet);
+
+// Processes the packets waiting in the pending batch
+void flushBatch();
+
+// Processes a batch whose packets stay valid until the call returns
+void runBatch(const packetBatch &batch);
+
+#endif
@@ -0,0 +1,190 @@
+#include "Capture.h"
+#include "Format.h"
+#include "Batch.h"
+
+#include <iostream>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+static volatile sig_atomic_t stop_requested = 0;
+
+void stopCapture()
+{
+    stop_requested = 1;
+}
+
+bool captureStopped()
+{
+    return stop_requested != 0;
+}
+
+pcap_t *openInteface(const std::string &interface)
+{
+    char errbuf[PCAP_ERRBUF_SIZE];
+    pcap_t *handle = pcap_open_live(interface.c_str(), BUFSIZ, 1, 1000, errbuf);
+    if (handle == nullptr)
+    {
+        std::cerr << "Could not open interface " << interface << ": " << errbuf << std::endl;
+        return nullptr;
+    }
+
+    std::cout << "Interface " << interface << " opened" << std::endl;
+
+    return handle;
+}
+
+bool openInterfaces(const std::string &interface_list, std::vector<captureInterface> &interfaces)
+{
+    size_t begin = 0;
+    while (begin <= interface_list.size())
+    {
+        size_t end = interface_list.find(',', begin);
+        if (end == std::string::npos)
+        {
+            end = interface_list.size();
+        }
+        std::string name = interface_list.substr(begin, end - begin);
+        begin = end + 1;
+
+        if (name.empty())
+        {
+            continue;
+        }
+
+        captureInterface interface;
+        interface.name = name;
+        interface.handle = openInteface(name);
+        if (interface.handle == nullptr)
+        {
+            return false;
+        }
+
+        char errbuf[PCAP_ERRBUF_SIZE];
+        if (pcap_setnonblock(interface.handle, 1, errbuf) == PCAP_ERROR)
+        {
+            std::cerr << "Could not set interface " << name << " to non-blocking mode: " << errbuf << std::endl;
+            pcap_close(interface.handle);
+            return false;
+        }
+
+        interface.fd = pcap_get_selectable_fd(interface.handle);
+        if (interface.fd < 0)
+        {
+            std::cerr << "Interface " << name << " has no selectable descriptor" << std::endl;
+            pcap_close(interface.handle);
+            return false;
+        }
+
+        interfaces.push_back(interface);
+    }
+
+    if (interfaces.empty())
+    {
+        std::cerr << "No interface specified" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void closeInterfaces(std::vector<captureInterface> &interfaces)
+{
+    for (size_t i = 0; i < interfaces.size(); i++)
+    {
+        if (interfaces[i].handle != nullptr)
+        {
+            pcap_close(interfaces[i].handle);
+            interfaces[i].handle = nullptr;
+        }
+    }
+}
+
+// takes one batch from the handle, false when the handle failed and was closed
+static bool dispatchInterface(captureInterface &interface, int epoll_fd, pcap_handler handler, u_char *user)
+{
+    int result = pcap_dispatch(interface.handle, CAPTURE_BATCH, handler, user);
+    // one dispatch is one batch, the next handle must not delay it
+    flushBatch();
+    if (result != PCAP_ERROR)
+    {
+        return true;
+    }
+
+    std::cerr << "Capture on interface " << interface.name << " failed: " << pcap_geterr(interface.handle) << std::endl;
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, interface.fd, nullptr);
+    pcap_close(interface.handle);
+    interface.handle = nullptr;
+    return false;
+}
+
+int runCaptureLoop(std::vector<captureInterface> &interfaces, pcap_handler handler, u_char *user)
+{
+    int epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0)
+    {
+        std::cerr << "Could not create epoll instance: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    for (size_t i = 0; i < interfaces.size(); i++)
+    {
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u32 = i;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, interfaces[i].fd, &event) != 0)
+        {
+            std::cerr << "Could not watch interface " << interfaces[i].name << ": " << std::strerror(errno) << std::endl;
+            close(epoll_fd);
+            return 1;
+        }
+    }
+
+    size_t open_count = interfaces.size();
+    struct epoll_event events[16];
+
+    while (open_count > 0 && !stop_requested)
+    {
+        int ready = epoll_wait(epoll_fd, events, 16, CAPTURE_POLL_TIMEOUT_MS);
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            std::cerr << "epoll_wait failed: " << std::strerror(errno) << std::endl;
+            close(epoll_fd);
+            return 1;
+        }
+
+        // the descriptor is not guaranteed to wake up when only the read timeout
+        // of a handle expires, so poll all of them when nothing became ready
+        if (ready == 0)
+        {
+            for (size_t i = 0; i < interfaces.size(); i++)
+            {
+                if (interfaces[i].handle != nullptr && !dispatchInterface(interfaces[i], epoll_fd, handler, user))
+                {
+                    open_count--;
+                }
+            }
+            flushOutput(standard_output);
+            continue;
+        }
+
+        for (int i = 0; i < ready; i++)
+        {
+            captureInterface &interface = interfaces[events[i].data.u32];
+            if (interface.handle != nullptr && !dispatchInterface(interface, epoll_fd, handler, user))
+            {
+                open_count--;
+            }
+        }
+        // keep the output of live capture current even when stdout is a pipe
+        flushOutput(standard_output);
+    }
+
+    close(epoll_fd);
+    return stop_requested ? 0 : 1;
+}
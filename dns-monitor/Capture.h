@@ -0,0 +1,40 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <pcap.h>
+#include <string>
+#include <vector>
+
+#define CAPTURE_BATCH 64               // packets taken from one handle per pcap_dispatch call
+#define CAPTURE_POLL_TIMEOUT_MS 1000   // same as the read timeout of the capture handles
+
+struct captureInterface {
+    std::string name;
+    pcap_t *handle;
+    int fd; // selectable descriptor registered in epoll
+};
+
+pcap_t *openInteface(const std::string &interface);
+
+/**
+ * @brief Opens every interface of a comma separated list as a non-blocking capture handle
+ *
+ * @return false if any of them could not be opened, the ones already opened stay in interfaces
+ */
+bool openInterfaces(const std::string &interface_list, std::vector<captureInterface> &interfaces);
+
+void closeInterfaces(std::vector<captureInterface> &interfaces);
+
+/**
+ * @brief Captures from all interfaces in one epoll loop, every packet goes to the same handler
+ *
+ * Returns when all handles failed, epoll itself fails or stopCapture was called.
+ */
+int runCaptureLoop(std::vector<captureInterface> &interfaces, pcap_handler handler, u_char *user);
+
+// Asks every capture, replay and file loop to return after the current batch, safe in a signal handler
+void stopCapture();
+
+bool captureStopped();
+
+#endif
@@ -0,0 +1,262 @@
+#include "Checkpoint.h"
+#include "Aggregates.h"
+#include "Format.h"
+#include "Batch.h"
+#include "Capture.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define CHECKPOINT_MAGIC "DNSCP01"
+#define CHECKPOINT_MAX_STRING 65535
+
+static int64_t modificationTime(const struct stat &file)
+{
+    return (int64_t)file.st_mtim.tv_sec * 1000000000 + file.st_mtim.tv_nsec;
+}
+
+static bool writeBytes(FILE *file, const void *data, uint64_t size)
+{
+    return std::fwrite(&size, sizeof(size), 1, file) == 1 && (size == 0 || std::fwrite(data, size, 1, file) == 1);
+}
+
+static bool writeString(FILE *file, const std::string &text)
+{
+    return writeBytes(file, text.data(), text.size());
+}
+
+static bool readString(FILE *file, std::string &text, uint64_t limit)
+{
+    uint64_t size;
+    if (std::fread(&size, sizeof(size), 1, file) != 1 || size > limit)
+    {
+        return false;
+    }
+    text.resize(size);
+    return size == 0 || std::fread(&text[0], size, 1, file) == 1;
+}
+
+static bool readCount(FILE *file, uint64_t &count)
+{
+    return std::fread(&count, sizeof(count), 1, file) == 1;
+}
+
+static bool readHeader(FILE *file, const std::string &pcap_path, checkpointHeader &header)
+{
+    struct stat capture;
+    return stat(pcap_path.c_str(), &capture) == 0 &&
+           std::fread(&header, sizeof(header), 1, file) == 1 &&
+           std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) == 0 &&
+           header.pcap_size == (uint64_t)capture.st_size &&
+           header.pcap_mtime == modificationTime(capture);
+}
+
+bool checkpointMatches(const std::string &checkpoint_path, const std::string &pcap_path)
+{
+    FILE *file = std::fopen(checkpoint_path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    checkpointHeader header;
+    bool matches = readHeader(file, pcap_path, header);
+    std::fclose(file);
+    return matches;
+}
+
+static bool saveCheckpoint(const std::string &checkpoint_path, const checkpointHeader &header, const checkpointState &state)
+{
+    std::string tmp_path = checkpoint_path + ".tmp";
+    FILE *file = std::fopen(tmp_path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   writeBytes(file, state.counters, state.counters_size);
+
+    uint64_t count = state.domains->size();
+    written = written && std::fwrite(&count, sizeof(count), 1, file) == 1;
+    for (std::set<std::string>::const_iterator it = state.domains->begin(); written && it != state.domains->end(); ++it)
+    {
+        written = writeString(file, *it);
+    }
+
+    count = state.translations->size();
+    written = written && std::fwrite(&count, sizeof(count), 1, file) == 1;
+    for (std::map<std::string, std::string>::const_iterator it = state.translations->begin(); written && it != state.translations->end(); ++it)
+    {
+        written = writeString(file, it->first) && writeString(file, it->second);
+    }
+
+    // one string per line, like the sets above
+    count = state.aliases->count;
+    written = written && std::fwrite(&count, sizeof(count), 1, file) == 1;
+    const std::string &lines = state.aliases->lines;
+    for (size_t begin = 0; written && begin < lines.size();)
+    {
+        size_t end = lines.find('\n', begin);
+        written = writeBytes(file, lines.data() + begin, end - begin);
+        begin = end + 1;
+    }
+
+    std::string aggregates;
+    saveAggregates(aggregates);
+    written = written && writeString(file, aggregates);
+
+    // the snapshot replaces the previous one only once it is on disk
+    written = written && std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+    if (std::fclose(file) != 0 || !written || std::rename(tmp_path.c_str(), checkpoint_path.c_str()) != 0)
+    {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+static bool loadCheckpoint(const std::string &checkpoint_path, const std::string &pcap_path, checkpointHeader &header, checkpointState &state)
+{
+    FILE *file = std::fopen(checkpoint_path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    std::string counters;
+    std::string aggregates;
+    std::string key;
+    std::string value;
+    uint64_t count = 0;
+
+    bool valid = readHeader(file, pcap_path, header) &&
+                 readString(file, counters, state.counters_size) && counters.size() == state.counters_size &&
+                 readCount(file, count);
+    for (uint64_t i = 0; valid && i < count; i++)
+    {
+        valid = readString(file, key, CHECKPOINT_MAX_STRING);
+        state.domains->insert(key);
+    }
+
+    valid = valid && readCount(file, count);
+    for (uint64_t i = 0; valid && i < count; i++)
+    {
+        valid = readString(file, key, CHECKPOINT_MAX_STRING) && readString(file, value, CHECKPOINT_MAX_STRING);
+        (*state.translations)[key] = value;
+    }
+
+    valid = valid && readCount(file, count);
+    for (uint64_t i = 0; valid && i < count; i++)
+    {
+        valid = readString(file, key, CHECKPOINT_MAX_STRING);
+        aliasInsert(*state.aliases, key.data(), key.size());
+    }
+
+    valid = valid && readString(file, aggregates, 4 * sizeof(aggregateWindow)) && restoreAggregates(aggregates);
+    std::fclose(file);
+
+    if (!valid)
+    {
+        state.domains->clear();
+        state.translations->clear();
+        clearAliases(*state.aliases);
+        restoreAggregates(std::string());
+        return false;
+    }
+    std::memcpy(state.counters, counters.data(), state.counters_size);
+    return true;
+}
+
+// the output files were truncated when they were opened, they get the restored entries again
+static void rewriteOutputs(const checkpointState &state)
+{
+    if (state.domains_file->is_open())
+    {
+        for (std::set<std::string>::const_iterator it = state.domains->begin(); it != state.domains->end(); ++it)
+        {
+            *state.domains_file << *it << '\n';
+        }
+        state.domains_file->flush();
+    }
+    if (state.translations_file->is_open())
+    {
+        for (std::map<std::string, std::string>::const_iterator it = state.translations->begin(); it != state.translations->end(); ++it)
+        {
+            *state.translations_file << it->second << " " << it->first << '\n';
+        }
+        state.translations_file->write(state.aliases->lines.data(), state.aliases->lines.size());
+        state.translations_file->flush();
+    }
+}
+
+int processCheckpointed(pcap_t *handle, const std::string &pcap_path, const std::string &checkpoint_path, unsigned interval,
+                        checkpointState &state, pcap_handler handler, u_char *user)
+{
+    FILE *pcap = pcap_file(handle);
+    struct stat capture;
+    if (pcap == nullptr || stat(pcap_path.c_str(), &capture) != 0)
+    {
+        std::cerr << "Checkpoints need a seekable pcap file" << std::endl;
+        return 1;
+    }
+
+    checkpointHeader header;
+    if (loadCheckpoint(checkpoint_path, pcap_path, header, state))
+    {
+        if (std::fseek(pcap, header.offset, SEEK_SET) != 0)
+        {
+            std::cerr << "Could not seek to the checkpoint in " << pcap_path << std::endl;
+            return 1;
+        }
+        rewriteOutputs(state);
+        std::cerr << "Resuming " << pcap_path << " after " << header.packets << " packets" << std::endl;
+    }
+    else
+    {
+        if (access(checkpoint_path.c_str(), F_OK) == 0)
+        {
+            std::cerr << "Checkpoint " << checkpoint_path << " does not belong to " << pcap_path << ", starting from the beginning" << std::endl;
+        }
+        std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+        header.pcap_size = capture.st_size;
+        header.pcap_mtime = modificationTime(capture);
+        header.packets = 0;
+    }
+
+    struct pcap_pkthdr *packet_header;
+    const u_char *packet;
+    int result = 0;
+    while (!captureStopped() && (result = pcap_next_ex(handle, &packet_header, &packet)) == 1)
+    {
+        handler(user, packet_header, packet);
+
+        if (++header.packets % interval == 0)
+        {
+            // the snapshot has to contain every packet before the offset
+            flushBatch();
+            flushOutput(standard_output);
+            header.offset = std::ftell(pcap);
+            if (!saveCheckpoint(checkpoint_path, header, state))
+            {
+                std::cerr << "Could not write checkpoint " << checkpoint_path << std::endl;
+            }
+        }
+    }
+
+    if (result == PCAP_ERROR)
+    {
+        std::cerr << "Error while reading " << pcap_path << ": " << pcap_geterr(handle) << std::endl;
+        return 1;
+    }
+
+    // an interrupted run keeps its last snapshot, a finished file starts from the beginning next time
+    if (captureStopped())
+    {
+        return 0;
+    }
+    std::remove(checkpoint_path.c_str());
+    return 0;
+}
@@ -0,0 +1,62 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <pcap.h>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+
+#include "AliasSet.h"
+
+#define CHECKPOINT_DEFAULT_INTERVAL 100000 // packets between two snapshots
+
+/*
+ * Offline runs write a snapshot of their progress every N packets: the file offset of
+ * the next packet record, the deduplication sets behind the domain and translation files,
+ * the counters and the open statistics windows. A run started with the same snapshot and
+ * the same pcap file continues after the last snapshot instead of from the beginning.
+ *
+ * Snapshots are written to a temporary file and renamed over the previous one, so an
+ * interrupted write leaves the last complete snapshot in place.
+ */
+
+#pragma pack(push, 1)
+struct checkpointHeader {
+    char magic[8];
+    uint64_t pcap_size;  // size and mtime of the pcap file being processed
+    int64_t pcap_mtime;  // nanoseconds
+    uint64_t offset;     // file offset of the next packet record
+    uint64_t packets;    // packets processed before the offset
+};
+#pragma pack(pop)
+
+// State of the run that is saved in every snapshot
+struct checkpointState {
+    std::set<std::string> *domains;                   // names written to the domains file
+    std::map<std::string, std::string> *translations; // ip -> name written to the translations file
+    aliasSet *aliases;                                // "alias ip" lines written to the translations file
+    std::ofstream *domains_file;
+    std::ofstream *translations_file;
+    void *counters;                                   // plain counter structure, saved as bytes
+    size_t counters_size;
+};
+
+/**
+ * @brief Checks whether the snapshot exists and belongs to the pcap file
+ */
+bool checkpointMatches(const std::string &checkpoint_path, const std::string &pcap_path);
+
+/**
+ * @brief Processes an opened pcap file, resuming from the snapshot when it matches
+ *
+ * The snapshot is removed when the whole file has been processed.
+ *
+ * @param interval packets between two snapshots
+ */
+int processCheckpointed(pcap_t *handle, const std::string &pcap_path, const std::string &checkpoint_path, unsigned interval,
+                        checkpointState &state, pcap_handler handler, u_char *user);
+
+#endif
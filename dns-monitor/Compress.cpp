@@ -0,0 +1,271 @@
+#include "Compress.h"
+#include "Affinity.h"
+
+#include <iostream>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <csignal>
+#include <pthread.h>
+#include <zlib.h>
+
+struct compressJob {
+    compressedSink *sink;
+    unsigned file_index;
+    std::string input;
+    std::string output;
+    bool done;
+};
+
+struct compressedSink {
+    std::string path;
+    uint64_t rotate_bytes;
+
+    // capture thread only
+    std::string block;
+    uint64_t file_bytes;
+    unsigned file_index;
+
+    // guarded by pool_mutex
+    std::deque<compressJob *> in_order; // submitted jobs, written from the front once done
+    bool writing;                       // a worker is appending to the file
+    bool failed;
+
+    // owned by the worker that has writing set
+    FILE *file;
+    unsigned open_index;
+};
+
+static std::mutex pool_mutex;
+static std::condition_variable work_ready;
+static std::condition_variable job_written;
+static std::deque<compressJob *> pending_jobs;
+static std::vector<std::thread> workers;
+static size_t in_flight = 0;
+static bool stopping = false;
+
+static std::string sinkFileName(const compressedSink *sink, unsigned index)
+{
+    if (sink->rotate_bytes == 0)
+    {
+        return sink->path;
+    }
+    std::string base = sink->path;
+    if (base.size() > 3 && base.compare(base.size() - 3, 3, ".gz") == 0)
+    {
+        base.resize(base.size() - 3);
+    }
+    return base + "." + std::to_string(index) + ".gz";
+}
+
+// compresses the input into one complete gzip member
+static bool compressBlock(compressJob *job)
+{
+    z_stream stream = z_stream();
+    // 15 window bits plus 16 selects the gzip wrapper
+    if (deflateInit2(&stream, COMPRESS_LEVEL, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return false;
+    }
+    job->output.resize(deflateBound(&stream, job->input.size()) + 32);
+    stream.next_in = (Bytef *)&job->input[0];
+    stream.avail_in = job->input.size();
+    stream.next_out = (Bytef *)&job->output[0];
+    stream.avail_out = job->output.size();
+    int result = deflate(&stream, Z_FINISH);
+    job->output.resize(job->output.size() - stream.avail_out);
+    deflateEnd(&stream);
+    return result == Z_STREAM_END;
+}
+
+// appends a compressed block, opening the next file on rotation
+static bool writeBlock(compressedSink *sink, const compressJob *job)
+{
+    if (sink->file == nullptr || sink->open_index != job->file_index)
+    {
+        if (sink->file != nullptr)
+        {
+            std::fclose(sink->file);
+        }
+        std::string name = sinkFileName(sink, job->file_index);
+        sink->file = std::fopen(name.c_str(), "wb");
+        sink->open_index = job->file_index;
+        if (sink->file == nullptr)
+        {
+            std::cerr << "Could not create " << name << std::endl;
+            return false;
+        }
+    }
+    return std::fwrite(job->output.data(), 1, job->output.size(), sink->file) == job->output.size();
+}
+
+static void workerLoop()
+{
+    // signals go to the capture thread, a worker must never run the handler or die of SIGHUP
+    sigset_t all;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, nullptr);
+    pinWorkerThread();
+
+    std::unique_lock<std::mutex> lock(pool_mutex);
+    for (;;)
+    {
+        work_ready.wait(lock, [] { return stopping || !pending_jobs.empty(); });
+        if (pending_jobs.empty())
+        {
+            return;
+        }
+        compressJob *job = pending_jobs.front();
+        pending_jobs.pop_front();
+
+        lock.unlock();
+        bool compressed = compressBlock(job);
+        lock.lock();
+
+        compressedSink *sink = job->sink;
+        job->done = true;
+        if (!compressed)
+        {
+            job->output.clear();
+            sink->failed = true;
+        }
+
+        // whoever finds the oldest block of the sink done writes it and all done blocks behind it
+        while (!sink->writing && !sink->in_order.empty() && sink->in_order.front()->done)
+        {
+            compressJob *next = sink->in_order.front();
+            sink->in_order.pop_front();
+            sink->writing = true;
+            lock.unlock();
+            bool written = next->output.empty() || writeBlock(sink, next);
+            lock.lock();
+            sink->writing = false;
+            sink->failed = sink->failed || !written;
+            delete next;
+            in_flight--;
+            job_written.notify_all();
+        }
+    }
+}
+
+bool startCompression(unsigned threads)
+{
+    stopping = false;
+    for (unsigned i = 0; i < threads; i++)
+    {
+        workers.push_back(std::thread(workerLoop));
+    }
+    return !workers.empty();
+}
+
+void stopCompression()
+{
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+    workers.clear();
+}
+
+compressedSink *openSink(const std::string &path, uint64_t rotate_bytes)
+{
+    compressedSink *sink = new compressedSink();
+    sink->path = path;
+    sink->rotate_bytes = rotate_bytes;
+    sink->block.reserve(COMPRESS_BLOCK_SIZE);
+
+    // the first file is created up front so a wrong path is reported at startup
+    sink->file = std::fopen(sinkFileName(sink, 0).c_str(), "wb");
+    if (sink->file == nullptr)
+    {
+        std::cerr << "Could not create " << sinkFileName(sink, 0) << std::endl;
+        delete sink;
+        return nullptr;
+    }
+    return sink;
+}
+
+// hands the current block to the workers
+static void submitBlock(compressedSink *sink)
+{
+    if (sink->block.empty())
+    {
+        return;
+    }
+
+    compressJob *job = new compressJob();
+    job->sink = sink;
+    job->file_index = sink->file_index;
+    job->done = false;
+    job->input.swap(sink->block);
+    sink->block.reserve(COMPRESS_BLOCK_SIZE);
+
+    sink->file_bytes += job->input.size();
+    if (sink->rotate_bytes != 0 && sink->file_bytes >= sink->rotate_bytes)
+    {
+        sink->file_index++;
+        sink->file_bytes = 0;
+    }
+
+    std::unique_lock<std::mutex> lock(pool_mutex);
+    job_written.wait(lock, [] { return in_flight < COMPRESS_MAX_IN_FLIGHT; });
+    in_flight++;
+    sink->in_order.push_back(job);
+    pending_jobs.push_back(job);
+    lock.unlock();
+    work_ready.notify_one();
+}
+
+void sinkWrite(compressedSink *sink, const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        size_t space = COMPRESS_BLOCK_SIZE - sink->block.size();
+        size_t part = length < space ? length : space;
+        sink->block.append(data, part);
+        data += part;
+        length -= part;
+        if (sink->block.size() == COMPRESS_BLOCK_SIZE)
+        {
+            submitBlock(sink);
+        }
+    }
+}
+
+double compressionBacklog()
+{
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    return (double)in_flight / COMPRESS_MAX_IN_FLIGHT;
+}
+
+void closeSink(compressedSink *sink)
+{
+    if (sink == nullptr)
+    {
+        return;
+    }
+    submitBlock(sink);
+
+    {
+        std::unique_lock<std::mutex> lock(pool_mutex);
+        job_written.wait(lock, [sink] { return sink->in_order.empty() && !sink->writing; });
+        if (sink->failed)
+        {
+            std::cerr << "Writing " << sink->path << " failed, the compressed output is incomplete" << std::endl;
+        }
+    }
+
+    if (sink->file != nullptr)
+    {
+        std::fclose(sink->file);
+    }
+    delete sink;
+}
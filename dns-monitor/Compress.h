@@ -0,0 +1,48 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#define COMPRESS_BLOCK_SIZE 262144 // text collected before a block is handed to the workers
+#define COMPRESS_MAX_IN_FLIGHT 64  // blocks waiting or being compressed, the writer waits above this
+#define COMPRESS_LEVEL 6           // zlib level, its usual speed/ratio trade-off
+
+/*
+ * Inline gzip compression of the output files. Text written to a sink is collected into
+ * blocks, every full block is compressed by a small worker pool into a separate gzip
+ * member, and the members are appended to the file in the order the blocks were
+ * written. Concatenated members form a valid gzip file, so zcat, zgrep and gunzip read
+ * the result directly. With rotation a sink moves to a new file <path>.<n>.gz after
+ * the given amount of text; a block never spans two files.
+ *
+ * The capture thread only copies text into the current block. It waits only when more
+ * than COMPRESS_MAX_IN_FLIGHT blocks are still being compressed, which bounds memory.
+ */
+
+struct compressedSink;
+
+// Starts the worker threads, must be called before any sink is opened
+bool startCompression(unsigned threads);
+
+// Waits for the pending blocks of all sinks and stops the workers
+void stopCompression();
+
+/**
+ * @brief Opens a compressed sink
+ *
+ * @param rotate_bytes text per file before the next one is started, 0 writes one file at path
+ * @return nullptr when the first file cannot be created
+ */
+compressedSink *openSink(const std::string &path, uint64_t rotate_bytes);
+
+void sinkWrite(compressedSink *sink, const char *data, size_t length);
+
+// Fill of the block queue between 0 and 1, the output blocks when it reaches 1
+double compressionBacklog();
+
+// Compresses the rest of the text, waits until everything is written and closes the file
+void closeSink(compressedSink *sink);
+
+#endif
@@ -0,0 +1,78 @@
+#include "Dedup.h"
+
+#include <cstring>
+
+struct dedupSet {
+    uint64_t keys[DEDUP_WAYS];  // 0 = empty
+    int64_t times[DEDUP_WAYS];  // microseconds of the first copy
+};
+
+static dedupSet *dedup_table = nullptr;
+static int64_t dedup_window = 0;
+
+void initDedup(unsigned window_ms)
+{
+    dedup_window = (int64_t)window_ms * 1000;
+    dedup_table = new dedupSet[DEDUP_SETS]();
+}
+
+bool dedupActive()
+{
+    return dedup_table != nullptr;
+}
+
+static inline uint64_t mix(uint64_t hash, uint64_t word)
+{
+    hash ^= word * 0x9e3779b97f4a7c15ULL;
+    hash = (hash << 27) | (hash >> 37);
+    return hash * 0xbf58476d1ce4e5b9ULL;
+}
+
+uint64_t dedupHash(const void *data, size_t length, uint64_t seed)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    uint64_t hash = mix(seed, length);
+    // eight bytes at a time, the tail is zero padded
+    for (; length >= 8; bytes += 8, length -= 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes, 8);
+        hash = mix(hash, word);
+    }
+    if (length > 0)
+    {
+        uint64_t word = 0;
+        std::memcpy(&word, bytes, length);
+        hash = mix(hash, word);
+    }
+    return hash ^ (hash >> 31);
+}
+
+bool isDuplicate(uint64_t key, const struct timeval &ts)
+{
+    if (key == 0)
+    {
+        key = 1;
+    }
+    int64_t now = (int64_t)ts.tv_sec * 1000000 + ts.tv_usec;
+    dedupSet &set = dedup_table[(key >> 32) & (DEDUP_SETS - 1)];
+
+    int victim = 0;
+    for (int way = 0; way < DEDUP_WAYS; way++)
+    {
+        int64_t age = now - set.times[way];
+        if (set.keys[way] == key && age <= dedup_window && age >= -dedup_window)
+        {
+            return true;
+        }
+        // an empty entry is taken first, otherwise the oldest one, which is also the one most likely expired
+        if (set.keys[victim] != 0 && (set.keys[way] == 0 || set.times[way] < set.times[victim]))
+        {
+            victim = way;
+        }
+    }
+
+    set.keys[victim] = key;
+    set.times[victim] = now;
+    return false;
+}
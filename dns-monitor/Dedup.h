@@ -0,0 +1,38 @@
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/time.h>
+
+#define DEDUP_SETS 16384 // sets of the table, each holds DEDUP_WAYS recent messages
+#define DEDUP_WAYS 4
+
+/*
+ * Short-horizon filter for client retransmissions and duplicates from mirror ports.
+ * A message is identified by a 64-bit hash of its addresses, ports and the whole UDP
+ * payload (DNS id included). The table has a fixed size and uses the packet timestamps
+ * as its clock: a copy seen again within the window is a duplicate, entries older than
+ * the window are free, and when a set is full the oldest entry is replaced.
+ */
+
+/**
+ * @brief Enables the filter
+ *
+ * @param window_ms how long a message is remembered
+ */
+void initDedup(unsigned window_ms);
+
+bool dedupActive();
+
+/**
+ * @brief Hashes bytes into the key of a message, chain calls through seed
+ */
+uint64_t dedupHash(const void *data, size_t length, uint64_t seed);
+
+/**
+ * @brief Remembers the message, true when the same key was seen within the window
+ */
+bool isDuplicate(uint64_t key, const struct timeval &ts);
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef DNSRING_H
+#define DNSRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#define DNS_RING_MAGIC "DNSRG01"
+#define DNS_RING_NAME_LENGTH 256    // longest presentation form of a name is 253 characters
+#define DNS_RING_WRITING UINT64_MAX // sequence of a slot while the producer fills it
+
+/*
+ * Layout of the shared-memory ring the monitor publishes decoded messages to
+ * (--publish <name>, a POSIX shared memory object). It is shared by the producer
+ * in Publish.cpp and the consumer library in RingReader.cpp.
+ *
+ * The ring has one producer and any number of consumers, which never write to it.
+ * Record n (counted from 1) lives in slot n % slot_count. The producer marks the
+ * slot with DNS_RING_WRITING, writes the record, stores n into the slot sequence
+ * and then n into write_sequence. A consumer copies a slot and checks that its
+ * sequence was n before and after the copy; anything else means the producer
+ * lapped it, the consumer skips ahead and counts the lost records.
+ */
+
+// Decoded DNS message, addresses in network order (pseudonyms with --anonymize)
+struct dnsRingRecord {
+    int64_t ts_sec;
+    int32_t ts_usec;
+    uint8_t family;      // AF_INET or AF_INET6
+    uint8_t watchlisted; // 1 when a question name is on the watchlist
+    uint16_t src_port;
+    uint16_t dst_port;
+    uint16_t id;
+    uint16_t flags;      // DNS header flags, the RCODE is in the low four bits
+    uint16_t qtype;      // first question, 0 when there is none
+    uint16_t qclass;
+    uint16_t counts[4];  // question, answer, authority and additional records
+    uint16_t size;       // size of the DNS message
+    uint8_t src[16];
+    uint8_t dst[16];
+    uint16_t qname_length;
+    char qname[DNS_RING_NAME_LENGTH]; // zero terminated, longer names are cut
+};
+
+struct alignas(64) dnsRingSlot {
+    std::atomic<uint64_t> sequence;
+    dnsRingRecord record;
+};
+
+struct alignas(64) dnsRingHeader {
+    char magic[8];
+    uint32_t slot_size; // sizeof(dnsRingSlot) of the producer
+    uint32_t slot_count; // power of two
+    std::atomic<uint32_t> closed; // set when the producer exits, the name is unlinked
+    alignas(64) std::atomic<uint64_t> write_sequence; // last published record
+};
+
+// slots start right after the header
+static inline dnsRingSlot *ringSlots(dnsRingHeader *header)
+{
+    return (dnsRingSlot *)(header + 1);
+}
+
+static inline size_t ringSize(uint32_t slot_count)
+{
+    return sizeof(dnsRingHeader) + (size_t)slot_count * sizeof(dnsRingSlot);
+}
+
+#endif
@@ -0,0 +1,232 @@
+#include "DomainStore.h"
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define STORE_MAGIC "DNSDS01"
+#define STORE_INITIAL_SLOTS 4096
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static std::string store_path;
+static int store_fd = -1;
+static domainStoreHeader *store_header = nullptr;
+static uint64_t *store_slots = nullptr;
+static size_t store_size = 0;
+
+static inline size_t storeFileSize(uint64_t slot_count)
+{
+    return sizeof(domainStoreHeader) + slot_count * sizeof(uint64_t);
+}
+
+static uint64_t storeKey(char kind, const char *key, size_t length)
+{
+    uint64_t hash = (FNV_OFFSET ^ (unsigned char)kind) * FNV_PRIME;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ (unsigned char)key[i]) * FNV_PRIME;
+    }
+    // 0 marks an empty slot
+    return hash == 0 ? 1 : hash;
+}
+
+static inline uint64_t slotIndex(uint64_t key, uint64_t mask)
+{
+    return (key ^ (key >> 32)) & mask;
+}
+
+// inserts into a table that is known to have a free slot, true when the key was new
+static bool insertSlot(uint64_t *slots, uint64_t mask, uint64_t key)
+{
+    for (uint64_t i = slotIndex(key, mask);; i = (i + 1) & mask)
+    {
+        if (slots[i] == key)
+        {
+            return false;
+        }
+        if (slots[i] == 0)
+        {
+            slots[i] = key;
+            return true;
+        }
+    }
+}
+
+// maps the file, fd stays open and locked
+static bool mapStore(int fd, size_t size)
+{
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+    store_header = (domainStoreHeader *)mapping;
+    store_slots = (uint64_t *)(store_header + 1);
+    store_size = size;
+    return true;
+}
+
+static void unmapStore()
+{
+    if (store_header != nullptr)
+    {
+        munmap(store_header, store_size);
+    }
+    store_header = nullptr;
+    store_slots = nullptr;
+    store_size = 0;
+}
+
+// creates an empty store file of the given size at path, returns the locked fd
+static int createStoreFile(const std::string &path, uint64_t slot_count)
+{
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    domainStoreHeader header;
+    std::memcpy(header.magic, STORE_MAGIC, sizeof(header.magic));
+    header.slot_count = slot_count;
+    header.entry_count = 0;
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0 || ftruncate(fd, storeFileSize(slot_count)) != 0 ||
+        pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// doubles the table into a new file that replaces the old one
+static bool growStore()
+{
+    uint64_t slot_count = store_header->slot_count * 2;
+    std::string tmp_path = store_path + ".tmp";
+    int fd = createStoreFile(tmp_path, slot_count);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    size_t size = storeFileSize(slot_count);
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        close(fd);
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    domainStoreHeader *header = (domainStoreHeader *)mapping;
+    uint64_t *slots = (uint64_t *)(header + 1);
+    for (uint64_t i = 0; i < store_header->slot_count; i++)
+    {
+        if (store_slots[i] != 0)
+        {
+            insertSlot(slots, slot_count - 1, store_slots[i]);
+        }
+    }
+    header->entry_count = store_header->entry_count;
+
+    if (msync(mapping, size, MS_SYNC) != 0 || std::rename(tmp_path.c_str(), store_path.c_str()) != 0)
+    {
+        munmap(mapping, size);
+        close(fd);
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    unmapStore();
+    close(store_fd);
+    store_fd = fd;
+    store_header = header;
+    store_slots = slots;
+    store_size = size;
+    return true;
+}
+
+bool openDomainStore(const std::string &path)
+{
+    store_path = path;
+    int fd = open(path.c_str(), O_RDWR);
+    if (fd < 0 && errno == ENOENT)
+    {
+        fd = createStoreFile(path, STORE_INITIAL_SLOTS);
+    }
+    else if (fd >= 0 && flock(fd, LOCK_EX | LOCK_NB) != 0)
+    {
+        std::cerr << "Store " << path << " is used by another process" << std::endl;
+        close(fd);
+        return false;
+    }
+    if (fd < 0)
+    {
+        std::cerr << "Could not open store " << path << std::endl;
+        return false;
+    }
+
+    struct stat file;
+    if (fstat(fd, &file) != 0 || (size_t)file.st_size < sizeof(domainStoreHeader) || !mapStore(fd, file.st_size))
+    {
+        std::cerr << "Could not map store " << path << std::endl;
+        close(fd);
+        return false;
+    }
+
+    uint64_t slot_count = store_header->slot_count;
+    if (std::memcmp(store_header->magic, STORE_MAGIC, sizeof(store_header->magic)) != 0 ||
+        slot_count == 0 || (slot_count & (slot_count - 1)) != 0 || store_size != storeFileSize(slot_count))
+    {
+        std::cerr << "Store " << path << " is damaged or has an unknown format" << std::endl;
+        unmapStore();
+        close(fd);
+        return false;
+    }
+
+    store_fd = fd;
+    std::cerr << "Store loaded: " << store_header->entry_count << " entries" << std::endl;
+    return true;
+}
+
+bool domainStoreActive()
+{
+    return store_header != nullptr;
+}
+
+bool storeInsert(char kind, const char *key, size_t length)
+{
+    // keep the load factor at or below one half, a failed resize only lengthens the probes
+    if ((store_header->entry_count + 1) * 2 > store_header->slot_count && !growStore() &&
+        store_header->entry_count + 1 >= store_header->slot_count)
+    {
+        // the table is full, report everything as new rather than losing output
+        return true;
+    }
+
+    if (!insertSlot(store_slots, store_header->slot_count - 1, storeKey(kind, key, length)))
+    {
+        return false;
+    }
+    store_header->entry_count++;
+    return true;
+}
+
+void closeDomainStore()
+{
+    if (store_header == nullptr)
+    {
+        return;
+    }
+    msync(store_header, store_size, MS_ASYNC);
+    unmapStore();
+    close(store_fd);
+    store_fd = -1;
+}
@@ -0,0 +1,46 @@
+#ifndef DOMAINSTORE_H
+#define DOMAINSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Kinds of keys kept in the store, each kind is hashed separately
+#define STORE_DOMAIN 'D'      // name written to the domains file
+#define STORE_TRANSLATION 'T' // ip written to the translations file
+#define STORE_ALIAS 'A'       // "alias ip" line written to the translations file
+
+/*
+ * Persistent set of everything already written to the domain and translation files.
+ * The store is a memory-mapped open addressing table of 64-bit hashes, opening it is a
+ * single mmap regardless of its size and every insertion goes straight to the mapping,
+ * so deduplication holds across restarts. The table doubles into a new file once it is
+ * half full.
+ */
+
+#pragma pack(push, 1)
+struct domainStoreHeader {
+    char magic[8];
+    uint64_t slot_count; // power of two
+    uint64_t entry_count;
+};
+#pragma pack(pop)
+
+/**
+ * @brief Opens or creates the store, the file is locked for the lifetime of the process
+ */
+bool openDomainStore(const std::string &path);
+
+// True when a store is open and write() should use it instead of the in-memory sets
+bool domainStoreActive();
+
+/**
+ * @brief Adds a key of the given kind
+ *
+ * @return true when the key was not in the store yet
+ */
+bool storeInsert(char kind, const char *key, size_t length);
+
+void closeDomainStore();
+
+#endif
@@ -0,0 +1,208 @@
+#include "Format.h"
+
+#include <ctime>
+
+outputBuffer standard_output = {{0}, 0, stdout, nullptr};
+
+static const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const char hex_digits[] = "0123456789abcdef";
+
+void flushOutput(outputBuffer &buffer)
+{
+    // the sink collects whole blocks, there is nothing to flush to the terminal
+    if (buffer.sink != nullptr)
+    {
+        sinkWrite(buffer.sink, buffer.data, buffer.used);
+        buffer.used = 0;
+        return;
+    }
+    if (buffer.used != 0)
+    {
+        std::fwrite(buffer.data, 1, buffer.used, buffer.file);
+        buffer.used = 0;
+    }
+    std::fflush(buffer.file);
+}
+
+void appendOutput(outputBuffer &buffer, const char *data, size_t length)
+{
+    if (length > OUTPUT_BUFFER_SIZE)
+    {
+        flushOutput(buffer);
+        if (buffer.sink != nullptr)
+        {
+            sinkWrite(buffer.sink, data, length);
+        }
+        else
+        {
+            std::fwrite(data, 1, length, buffer.file);
+        }
+        return;
+    }
+    std::memcpy(reserveOutput(buffer, length), data, length);
+    commitOutput(buffer, length);
+}
+
+size_t formatUnsigned(char *out, uint64_t value)
+{
+    char digits[20];
+    char *end = digits + sizeof(digits);
+    char *begin = end;
+
+    while (value >= 100)
+    {
+        unsigned pair = (value % 100) * 2;
+        value /= 100;
+        *--begin = digit_pairs[pair + 1];
+        *--begin = digit_pairs[pair];
+    }
+    if (value >= 10)
+    {
+        *--begin = digit_pairs[value * 2 + 1];
+        *--begin = digit_pairs[value * 2];
+    }
+    else
+    {
+        *--begin = (char)('0' + value);
+    }
+
+    size_t length = end - begin;
+    std::memcpy(out, begin, length);
+    return length;
+}
+
+size_t formatHex(char *out, uint32_t value)
+{
+    int shift = 28;
+    while (shift > 0 && ((value >> shift) & 0xF) == 0)
+    {
+        shift -= 4;
+    }
+    size_t length = 0;
+    for (; shift >= 0; shift -= 4)
+    {
+        out[length++] = hex_digits[(value >> shift) & 0xF];
+    }
+    return length;
+}
+
+size_t formatIPv4(char *out, const uint8_t *address)
+{
+    size_t length = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        uint8_t octet = address[i];
+        if (octet >= 100)
+        {
+            out[length++] = (char)('0' + octet / 100);
+            octet %= 100;
+            out[length++] = digit_pairs[octet * 2];
+            out[length++] = digit_pairs[octet * 2 + 1];
+        }
+        else if (octet >= 10)
+        {
+            out[length++] = digit_pairs[octet * 2];
+            out[length++] = digit_pairs[octet * 2 + 1];
+        }
+        else
+        {
+            out[length++] = (char)('0' + octet);
+        }
+        out[length++] = '.';
+    }
+    return length - 1;
+}
+
+size_t formatIPv6(char *out, const uint8_t *address)
+{
+    uint16_t words[8];
+    for (int i = 0; i < 8; i++)
+    {
+        words[i] = (uint16_t)(address[2 * i] << 8 | address[2 * i + 1]);
+    }
+
+    // the longest run of at least two zero words is shortened to "::", the first one on a tie
+    int best_base = -1;
+    int best_length = 0;
+    for (int i = 0; i < 8;)
+    {
+        if (words[i] != 0)
+        {
+            i++;
+            continue;
+        }
+        int run = i;
+        while (i < 8 && words[i] == 0)
+        {
+            i++;
+        }
+        if (i - run > best_length)
+        {
+            best_base = run;
+            best_length = i - run;
+        }
+    }
+    if (best_length < 2)
+    {
+        best_base = -1;
+    }
+
+    size_t length = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        if (best_base != -1 && i >= best_base && i < best_base + best_length)
+        {
+            if (i == best_base)
+            {
+                out[length++] = ':';
+            }
+            continue;
+        }
+        if (i != 0)
+        {
+            out[length++] = ':';
+        }
+        // IPv4-compatible and IPv4-mapped addresses end in dotted notation, as in inet_ntop
+        if (i == 6 && best_base == 0 && (best_length == 6 || (best_length == 5 && words[5] == 0xffff)))
+        {
+            return length + formatIPv4(out + length, address + 12);
+        }
+        length += formatHex(out + length, words[i]);
+    }
+    if (best_base != -1 && best_base + best_length == 8)
+    {
+        out[length++] = ':';
+    }
+    return length;
+}
+
+size_t formatTimestamp(char *out, const struct timeval &ts)
+{
+    static time_t cached_second = (time_t)-1;
+    static char cached_prefix[20]; // "YYYY-MM-DD HH:MM:SS"
+
+    if (ts.tv_sec != cached_second)
+    {
+        struct tm local;
+        localtime_r(&ts.tv_sec, &local);
+        char text[32];
+        strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &local);
+        std::memcpy(cached_prefix, text, sizeof(cached_prefix) - 1);
+        cached_second = ts.tv_sec;
+    }
+
+    std::memcpy(out, cached_prefix, sizeof(cached_prefix) - 1);
+    char *fraction = out + sizeof(cached_prefix) - 1;
+    *fraction++ = '.';
+    unsigned microseconds = (unsigned)ts.tv_usec;
+    for (int i = 5; i >= 0; i--)
+    {
+        fraction[i] = (char)('0' + microseconds % 10);
+        microseconds /= 10;
+    }
+    return TIMESTAMP_LENGTH;
+}
@@ -0,0 +1,69 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include "Compress.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sys/time.h>
+
+#define OUTPUT_BUFFER_SIZE 65536
+#define TIMESTAMP_LENGTH 26 // "YYYY-MM-DD HH:MM:SS.uuuuuu"
+#define IP_TEXT_LENGTH 46   // INET6_ADDRSTRLEN
+
+/*
+ * Output formatting without iostream or locale. Lines are assembled in a reusable
+ * buffer with the format* routines below and written out in large chunks, the
+ * date and time part of the timestamp is formatted once per second.
+ */
+
+struct outputBuffer {
+    char data[OUTPUT_BUFFER_SIZE];
+    size_t used;
+    FILE *file;
+    compressedSink *sink; // takes the output instead of file when set
+};
+
+extern outputBuffer standard_output;
+
+void flushOutput(outputBuffer &buffer);
+
+// returns space for at least length bytes (length <= OUTPUT_BUFFER_SIZE), flushing when needed
+static inline char *reserveOutput(outputBuffer &buffer, size_t length)
+{
+    if (buffer.used + length > OUTPUT_BUFFER_SIZE)
+    {
+        flushOutput(buffer);
+    }
+    return buffer.data + buffer.used;
+}
+
+static inline void commitOutput(outputBuffer &buffer, size_t length)
+{
+    buffer.used += length;
+}
+
+void appendOutput(outputBuffer &buffer, const char *data, size_t length);
+
+static inline void appendOutput(outputBuffer &buffer, const char *text)
+{
+    appendOutput(buffer, text, std::strlen(text));
+}
+
+static inline void appendUnsigned(outputBuffer &buffer, uint64_t value);
+
+// Each routine writes to out without a terminating zero and returns the number of characters
+size_t formatUnsigned(char *out, uint64_t value);
+size_t formatHex(char *out, uint32_t value);
+size_t formatIPv4(char *out, const uint8_t *address);
+size_t formatIPv6(char *out, const uint8_t *address); // same text as inet_ntop
+size_t formatTimestamp(char *out, const struct timeval &ts); // local time with microseconds
+
+static inline void appendUnsigned(outputBuffer &buffer, uint64_t value)
+{
+    commitOutput(buffer, formatUnsigned(reserveOutput(buffer, 20), value));
+}
+
+#endif
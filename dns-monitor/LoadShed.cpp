@@ -0,0 +1,87 @@
+#include "LoadShed.h"
+#include "Compress.h"
+
+#include <iostream>
+
+// pressure at which each level is entered, 1.0 is the whole lag budget or a full queue
+static const double watermarks[] = {0.0, 0.25, 0.5, 1.0};
+static const char *level_names[] = {"none", "verbose", "sections", "sample"};
+
+static bool active = false;
+static double lag_budget_ns = 0;
+static int64_t latest_lag_ns = 0;
+static SHED_LEVEL level = SHED_NONE;
+static unsigned sample_counter = 0;
+static uint64_t shed_counts[SHED_SAMPLE + 1];
+static uint64_t level_changes = 0;
+
+void initShedding(unsigned lag_budget_ms)
+{
+    active = true;
+    lag_budget_ns = (double)lag_budget_ms * 1000000;
+}
+
+bool sheddingActive()
+{
+    return active;
+}
+
+void reportLag(int64_t lag_ns)
+{
+    latest_lag_ns = lag_ns;
+}
+
+SHED_LEVEL updateShedLevel()
+{
+    double pressure = lag_budget_ns > 0 ? latest_lag_ns / lag_budget_ns : 0;
+    double backlog = compressionBacklog();
+    if (backlog > pressure)
+    {
+        pressure = backlog;
+    }
+
+    SHED_LEVEL next = level;
+    // up as far as the pressure reaches, down one level at a time below half of the watermark
+    while (next < SHED_SAMPLE && pressure >= watermarks[next + 1])
+    {
+        next = (SHED_LEVEL)(next + 1);
+    }
+    if (next == level && level > SHED_NONE && pressure < watermarks[level] / 2)
+    {
+        next = (SHED_LEVEL)(level - 1);
+    }
+
+    if (next != level)
+    {
+        level_changes++;
+        std::cerr << "Load shedding " << level_names[level] << " -> " << level_names[next]
+                  << " (lag " << latest_lag_ns / 1000000.0 << " ms, compression queue " << (int)(backlog * 100) << " %)" << std::endl;
+        level = next;
+    }
+    return level;
+}
+
+bool sampleMessage()
+{
+    if (++sample_counter == SHED_SAMPLE_RATE)
+    {
+        sample_counter = 0;
+        return true;
+    }
+    return false;
+}
+
+void countShed(SHED_LEVEL shed)
+{
+    shed_counts[shed]++;
+}
+
+void printSheddingReport()
+{
+    if (!active)
+    {
+        return;
+    }
+    std::cerr << "Shed: " << shed_counts[SHED_VERBOSE] << " verbose, " << shed_counts[SHED_SECTIONS] << " sections, "
+              << shed_counts[SHED_SAMPLE] << " sampled out, " << level_changes << " level changes" << std::endl;
+}
@@ -0,0 +1,59 @@
+#ifndef LOADSHED_H
+#define LOADSHED_H
+
+#include <cstdint>
+
+#define SHED_SAMPLE_RATE 8 // at SHED_SAMPLE one message in this many is still printed
+
+/*
+ * Load shedding for live captures and paced replays. Two stages can fall behind
+ * the capture: the decoding and output of messages, seen as the lag between a
+ * packet's due time and the time it is processed, and the compression workers,
+ * seen as the fill of their bounded queue (Compress.h), which blocks the output
+ * when it is full. The larger of lag / budget and the queue fill is the pressure.
+ *
+ * Past a watermark of the pressure the monitor sheds work in a fixed order, each
+ * level includes the ones before it. A level is left when the pressure falls below
+ * half of its watermark, so it does not flap around the threshold. Every message
+ * is still counted in the statistics (--stats), only its rendering is reduced: at
+ * every level the first question and the OPT record are decoded for the statistics,
+ * the detector and the watchlist.
+ */
+
+enum SHED_LEVEL
+{
+    SHED_NONE,
+    SHED_VERBOSE,  // verbose output is replaced by the one-line form
+    SHED_SECTIONS, // only the DNS header is printed, only the question and OPT record are decoded
+    SHED_SAMPLE    // only one message in SHED_SAMPLE_RATE is printed
+};
+
+/**
+ * @brief Enables shedding
+ *
+ * @param lag_budget_ms lag at which the last level is reached
+ */
+void initShedding(unsigned lag_budget_ms);
+
+bool sheddingActive();
+
+// Latest lag of the capture or replay behind its packets, in nanoseconds
+void reportLag(int64_t lag_ns);
+
+/**
+ * @brief Applies the watermarks to the current pressure, called once per batch
+ *
+ * @return level the batch is processed at
+ */
+SHED_LEVEL updateShedLevel();
+
+// True for the messages printed at SHED_SAMPLE
+bool sampleMessage();
+
+// Counts one message that was processed below full detail because of level
+void countShed(SHED_LEVEL level);
+
+// Prints the counters to stderr, nothing when shedding is off
+void printSheddingReport();
+
+#endif
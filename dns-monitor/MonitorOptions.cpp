@@ -0,0 +1,120 @@
+#include "MonitorOptions.h"
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <cerrno>
+
+struct stringOption {
+    const char *name;
+    std::string monitorOptions::*value;
+};
+
+static const stringOption string_options[] = {
+    {"--watchlist", &monitorOptions::watchlist_file},
+    {"--stats", &monitorOptions::stats_file},
+    {"--xdp", &monitorOptions::xdp_interface},
+    {"--xdp-mode", &monitorOptions::xdp_mode},
+    {"--from", &monitorOptions::range_from},
+    {"--to", &monitorOptions::range_to},
+    {"--checkpoint", &monitorOptions::checkpoint_file},
+    {"--store", &monitorOptions::store_file},
+    {"--cpus", &monitorOptions::capture_cpus},
+    {"--worker-cpus", &monitorOptions::worker_cpus},
+    {"--replay", &monitorOptions::replay_speed},
+    {"--alerts", &monitorOptions::alerts_file},
+    {"--output", &monitorOptions::output_file},
+    {"--domains-gz", &monitorOptions::domains_gz_file},
+    {"--translations-gz", &monitorOptions::translations_gz_file},
+    {"--anonymize", &monitorOptions::anonymize_key},
+    {"--publish", &monitorOptions::publish_name},
+};
+
+struct unsignedOption {
+    const char *name;
+    unsigned monitorOptions::*value;
+};
+
+static const unsignedOption unsigned_options[] = {
+    {"--xdp-queues", &monitorOptions::xdp_queues},
+    {"--build-index", &monitorOptions::index_interval},
+    {"--checkpoint-interval", &monitorOptions::checkpoint_interval},
+    {"--dedup", &monitorOptions::dedup_window},
+    {"--loop", &monitorOptions::replay_loops},
+    {"--rotate-size", &monitorOptions::rotate_size},
+    {"--compress-threads", &monitorOptions::compress_threads},
+    {"--publish-slots", &monitorOptions::publish_slots},
+    {"--shed", &monitorOptions::shed_lag},
+};
+
+// parses a decimal value that fits into unsigned
+static bool parseUnsigned(const char *text, unsigned &value)
+{
+    char *end;
+    errno = 0;
+    unsigned long parsed = std::strtoul(text, &end, 10);
+    if (errno != 0 || end == text || *end != '\0' || text[0] == '-' || parsed > UINT_MAX)
+    {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+bool parseMonitorOptions(int &argc, char *argv[], monitorOptions &options)
+{
+    int remaining = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        // everything that is not a long option is left for parseArguments
+        if (std::strncmp(argv[i], "--", 2) != 0)
+        {
+            argv[remaining++] = argv[i];
+            continue;
+        }
+
+        bool known = false;
+        for (size_t j = 0; j < sizeof(string_options) / sizeof(string_options[0]); j++)
+        {
+            if (std::strcmp(argv[i], string_options[j].name) != 0)
+            {
+                continue;
+            }
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for option " << argv[i] << std::endl;
+                return false;
+            }
+            options.*string_options[j].value = argv[++i];
+            known = true;
+            break;
+        }
+
+        for (size_t j = 0; !known && j < sizeof(unsigned_options) / sizeof(unsigned_options[0]); j++)
+        {
+            if (std::strcmp(argv[i], unsigned_options[j].name) != 0)
+            {
+                continue;
+            }
+            if (i + 1 >= argc || !parseUnsigned(argv[i + 1], options.*unsigned_options[j].value))
+            {
+                std::cerr << "Option " << argv[i] << " needs a number" << std::endl;
+                return false;
+            }
+            i++;
+            known = true;
+        }
+
+        if (!known)
+        {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return false;
+        }
+    }
+
+    argv[remaining] = nullptr;
+    argc = remaining;
+    return true;
+}
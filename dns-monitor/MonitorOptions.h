@@ -0,0 +1,49 @@
+#ifndef MONITOROPTIONS_H
+#define MONITOROPTIONS_H
+
+#include <string>
+
+// Options that extend the basic -i/-p/-v/-d/-t set handled by parseArguments.
+// They are all long options (--name value), so they can be separated from argv
+// before the rest is handed over to the argument parser.
+struct monitorOptions
+{
+    std::string watchlist_file;            // --watchlist <file>
+    std::string stats_file;                // --stats <file>
+    std::string xdp_interface;             // --xdp <interface>
+    std::string xdp_mode;                  // --xdp-mode skb|native
+    unsigned xdp_queues = 1;               // --xdp-queues <count>
+    unsigned index_interval = 0;           // --build-index <packets>, 0 when no index is built
+    std::string range_from;                // --from <time>
+    std::string range_to;                  // --to <time>
+    std::string checkpoint_file;           // --checkpoint <file>
+    unsigned checkpoint_interval = 100000; // --checkpoint-interval <packets>
+    std::string store_file;                // --store <file>
+    std::string capture_cpus;              // --cpus <list>|auto
+    std::string worker_cpus;               // --worker-cpus <list>
+    unsigned dedup_window = 0;             // --dedup <ms>, 0 keeps every copy
+    std::string replay_speed;              // --replay <speed>|max
+    unsigned replay_loops = 1;             // --loop <count>, 0 until interrupted
+    std::string alerts_file;               // --alerts <file>|-
+    std::string output_file;               // --output <file>, gzip instead of stdout
+    std::string domains_gz_file;           // --domains-gz <file>
+    std::string translations_gz_file;      // --translations-gz <file>
+    unsigned rotate_size = 0;              // --rotate-size <MiB>, 0 writes one file
+    unsigned compress_threads = 2;         // --compress-threads <count>
+    std::string anonymize_key;             // --anonymize <key file>
+    std::string publish_name;              // --publish <shared memory name>
+    unsigned publish_slots = 65536;        // --publish-slots <count>, rounded up to a power of two
+    unsigned shed_lag = 0;                 // --shed <ms> of lag at which only sampled headers are printed, 0 = off
+};
+
+/**
+ * @brief Removes the long options known to the monitor from argv and stores them in options
+ *
+ * @param argc argument count, updated to the number of remaining arguments
+ * @param argv argument vector, compacted in place
+ * @param options parsed options
+ * @return false if an unknown long option or a missing value was found
+ */
+bool parseMonitorOptions(int &argc, char *argv[], monitorOptions &options);
+
+#endif
@@ -0,0 +1,207 @@
+#include "PcapIndex.h"
+#include "Capture.h"
+
+#include <iostream>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <sys/stat.h>
+
+#define PCAP_INDEX_MAGIC "DNSPIX1"
+
+static inline int64_t packetTime(const struct pcap_pkthdr *header)
+{
+    return (int64_t)header->ts.tv_sec * 1000000 + header->ts.tv_usec;
+}
+
+static int64_t modificationTime(const struct stat &file)
+{
+    return (int64_t)file.st_mtim.tv_sec * 1000000000 + file.st_mtim.tv_nsec;
+}
+
+bool buildPcapIndex(const std::string &pcap_path, unsigned interval)
+{
+    struct stat capture;
+    char errbuf[PCAP_ERRBUF_SIZE];
+    pcap_t *handle = pcap_open_offline(pcap_path.c_str(), errbuf);
+    if (handle == nullptr || stat(pcap_path.c_str(), &capture) != 0)
+    {
+        std::cerr << "Could not open pcap file " << pcap_path << ": " << errbuf << std::endl;
+        return false;
+    }
+
+    std::vector<pcapIndexEntry> entries;
+    FILE *file = pcap_file(handle);
+    struct pcap_pkthdr *header;
+    const u_char *packet;
+    uint64_t packets = 0;
+
+    for (;;)
+    {
+        long offset = std::ftell(file);
+        int result = pcap_next_ex(handle, &header, &packet);
+        if (result != 1)
+        {
+            if (result == PCAP_ERROR)
+            {
+                std::cerr << "Error while reading " << pcap_path << ": " << pcap_geterr(handle) << std::endl;
+            }
+            break;
+        }
+        if (packets++ % interval == 0)
+        {
+            pcapIndexEntry entry;
+            entry.ts = packetTime(header);
+            entry.offset = offset;
+            entries.push_back(entry);
+        }
+    }
+    pcap_close(handle);
+
+    pcapIndexHeader index;
+    std::memcpy(index.magic, PCAP_INDEX_MAGIC, sizeof(index.magic));
+    index.interval = interval;
+    index.entry_count = entries.size();
+    index.pcap_size = capture.st_size;
+    index.pcap_mtime = modificationTime(capture);
+
+    std::string index_path = pcap_path + ".idx";
+    std::string tmp_path = index_path + ".tmp";
+    FILE *out = std::fopen(tmp_path.c_str(), "wb");
+    if (out == nullptr)
+    {
+        std::cerr << "Could not create index " << index_path << std::endl;
+        return false;
+    }
+    bool written = std::fwrite(&index, sizeof(index), 1, out) == 1 &&
+                   std::fwrite(entries.data(), sizeof(pcapIndexEntry), entries.size(), out) == entries.size();
+    if (std::fclose(out) != 0 || !written || std::rename(tmp_path.c_str(), index_path.c_str()) != 0)
+    {
+        std::remove(tmp_path.c_str());
+        std::cerr << "Could not write index " << index_path << std::endl;
+        return false;
+    }
+
+    std::cout << "Indexed " << packets << " packets of " << pcap_path << " in " << entries.size() << " checkpoints" << std::endl;
+    return true;
+}
+
+// loads the index of the capture, false when there is none or it is out of date
+static bool loadPcapIndex(const std::string &pcap_path, std::vector<pcapIndexEntry> &entries)
+{
+    struct stat capture;
+    if (stat(pcap_path.c_str(), &capture) != 0)
+    {
+        return false;
+    }
+
+    FILE *file = std::fopen((pcap_path + ".idx").c_str(), "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    pcapIndexHeader index;
+    bool valid = std::fread(&index, sizeof(index), 1, file) == 1 &&
+                 std::memcmp(index.magic, PCAP_INDEX_MAGIC, sizeof(index.magic)) == 0 &&
+                 index.pcap_size == (uint64_t)capture.st_size &&
+                 index.pcap_mtime == modificationTime(capture);
+    if (valid)
+    {
+        entries.resize(index.entry_count);
+        valid = std::fread(entries.data(), sizeof(pcapIndexEntry), entries.size(), file) == entries.size();
+    }
+    std::fclose(file);
+    return valid;
+}
+
+bool parseTime(const std::string &text, int64_t &usec)
+{
+    const char *begin = text.c_str();
+    char *end;
+
+    // seconds since the epoch, optionally with a fraction
+    double seconds = std::strtod(begin, &end);
+    if (end != begin && *end == '\0')
+    {
+        usec = (int64_t)(seconds * 1000000);
+        return true;
+    }
+
+    struct tm local;
+    std::memset(&local, 0, sizeof(local));
+    end = strptime(begin, "%Y-%m-%d %H:%M:%S", &local);
+    if (end == nullptr)
+    {
+        return false;
+    }
+    local.tm_isdst = -1;
+    usec = (int64_t)mktime(&local) * 1000000;
+
+    if (*end == '.')
+    {
+        int64_t scale = 100000;
+        for (end++; *end >= '0' && *end <= '9' && scale > 0; end++, scale /= 10)
+        {
+            usec += (*end - '0') * scale;
+        }
+    }
+    return *end == '\0';
+}
+
+int processTimeRange(pcap_t *handle, const std::string &pcap_path, int64_t from, int64_t to, pcap_handler handler, u_char *user)
+{
+    std::vector<pcapIndexEntry> entries;
+    if (loadPcapIndex(pcap_path, entries))
+    {
+        // last checkpoint safely before the start of the range
+        int64_t start = from - PCAP_INDEX_SLACK_USEC;
+        size_t low = 0;
+        size_t high = entries.size();
+        while (low < high)
+        {
+            size_t middle = (low + high) / 2;
+            if (entries[middle].ts <= start)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        if (low > 0 && std::fseek(pcap_file(handle), entries[low - 1].offset, SEEK_SET) != 0)
+        {
+            std::cerr << "Could not seek in " << pcap_path << ", reading from the start" << std::endl;
+        }
+    }
+    else
+    {
+        std::cerr << "No up-to-date index for " << pcap_path << ", reading from the start" << std::endl;
+    }
+
+    struct pcap_pkthdr *header;
+    const u_char *packet;
+    int result = 0;
+    while (!captureStopped() && (result = pcap_next_ex(handle, &header, &packet)) == 1)
+    {
+        int64_t ts = packetTime(header);
+        if (ts > to + PCAP_INDEX_SLACK_USEC)
+        {
+            break;
+        }
+        if (ts >= from && ts <= to)
+        {
+            handler(user, header, packet);
+        }
+    }
+
+    if (result == PCAP_ERROR)
+    {
+        std::cerr << "Error while reading " << pcap_path << ": " << pcap_geterr(handle) << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+#ifndef PCAPINDEX_H
+#define PCAPINDEX_H
+
+#include <pcap.h>
+#include <cstdint>
+#include <string>
+
+// Packets may be slightly out of order in captures from several queues or interfaces,
+// seeking starts this much before the range and reading stops this much after it
+#define PCAP_INDEX_SLACK_USEC 1000000
+
+/*
+ * Sidecar index <capture>.idx with a (timestamp, file offset) checkpoint every N packets.
+ * It lets the offline mode seek close to the start of a time range instead of reading
+ * the capture from the beginning.
+ */
+
+#pragma pack(push, 1)
+struct pcapIndexHeader {
+    char magic[8];
+    uint64_t interval;     // packets between checkpoints
+    uint64_t entry_count;
+    uint64_t pcap_size;    // size and mtime of the capture the index belongs to
+    int64_t pcap_mtime;    // nanoseconds
+};
+
+struct pcapIndexEntry {
+    int64_t ts;      // microseconds since the epoch
+    uint64_t offset; // file offset of the packet record
+};
+#pragma pack(pop)
+
+/**
+ * @brief Reads the whole capture and writes <pcap_path>.idx
+ *
+ * @param interval packets between two checkpoints
+ */
+bool buildPcapIndex(const std::string &pcap_path, unsigned interval);
+
+/**
+ * @brief Parses "YYYY-MM-DD HH:MM:SS[.uuuuuu]" in local time, or seconds since the epoch
+ *
+ * @return false when the text is neither
+ */
+bool parseTime(const std::string &text, int64_t &usec);
+
+/**
+ * @brief Processes only the packets of an opened capture whose timestamps fall into [from, to]
+ *
+ * Uses the index when there is an up-to-date one, otherwise reads the capture from the start.
+ */
+int processTimeRange(pcap_t *handle, const std::string &pcap_path, int64_t from, int64_t to, pcap_handler handler, u_char *user);
+
+#endif
@@ -0,0 +1,101 @@
+#include "Publish.h"
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static dnsRingHeader *ring = nullptr;
+static dnsRingSlot *slots = nullptr;
+static std::string ring_name;
+static uint64_t next_sequence = 1;
+static uint32_t slot_mask = 0;
+
+bool initPublisher(const std::string &name, unsigned slot_count)
+{
+    ring_name = name[0] == '/' ? name : "/" + name;
+    uint32_t count = 1;
+    while (count < slot_count && count < (1u << 31))
+    {
+        count <<= 1;
+    }
+
+    // a fresh object, so consumers of an earlier run keep their old mapping and see it closed
+    shm_unlink(ring_name.c_str());
+    int fd = shm_open(ring_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        std::cerr << "Could not create shared memory " << ring_name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    size_t size = ringSize(count);
+    if (ftruncate(fd, size) != 0)
+    {
+        std::cerr << "Could not size shared memory " << ring_name << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        shm_unlink(ring_name.c_str());
+        return false;
+    }
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "Could not map shared memory " << ring_name << ": " << std::strerror(errno) << std::endl;
+        shm_unlink(ring_name.c_str());
+        return false;
+    }
+
+    // the object is zero filled, every sequence starts at 0 = never written
+    ring = (dnsRingHeader *)mapping;
+    ring->slot_size = sizeof(dnsRingSlot);
+    ring->slot_count = count;
+    slots = ringSlots(ring);
+    slot_mask = count - 1;
+    // the magic goes last, consumers only attach to a complete header
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(ring->magic, DNS_RING_MAGIC, sizeof(ring->magic));
+
+    std::cerr << "Publishing to " << ring_name << " (" << count << " slots)" << std::endl;
+    return true;
+}
+
+bool publisherActive()
+{
+    return ring != nullptr;
+}
+
+dnsRingRecord *beginRecord()
+{
+    dnsRingSlot &slot = slots[next_sequence & slot_mask];
+    slot.sequence.store(DNS_RING_WRITING, std::memory_order_relaxed);
+    // readers that see the old sequence after copying must not have seen the new data
+    std::atomic_thread_fence(std::memory_order_release);
+    return &slot.record;
+}
+
+void commitRecord()
+{
+    slots[next_sequence & slot_mask].sequence.store(next_sequence, std::memory_order_release);
+    ring->write_sequence.store(next_sequence, std::memory_order_release);
+    next_sequence++;
+}
+
+uint64_t publishedRecords()
+{
+    return next_sequence - 1;
+}
+
+void closePublisher()
+{
+    if (ring == nullptr)
+    {
+        return;
+    }
+    ring->closed.store(1, std::memory_order_release);
+    munmap(ring, ringSize(ring->slot_count));
+    shm_unlink(ring_name.c_str());
+    ring = nullptr;
+    slots = nullptr;
+}
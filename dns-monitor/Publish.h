@@ -0,0 +1,35 @@
+#ifndef PUBLISH_H
+#define PUBLISH_H
+
+#include "DnsRing.h"
+
+#include <string>
+
+#define PUBLISH_DEFAULT_SLOTS 65536
+
+/**
+ * @brief Creates the shared memory ring, replacing one left by an earlier run
+ *
+ * @param name POSIX shared memory name, a leading '/' is added when missing
+ * @param slot_count records kept in the ring, rounded up to a power of two
+ */
+bool initPublisher(const std::string &name, unsigned slot_count);
+
+bool publisherActive();
+
+/**
+ * @brief Returns the slot of the next record, filled in place and published by commitRecord
+ */
+dnsRingRecord *beginRecord();
+
+void commitRecord();
+
+// Number of records published so far
+uint64_t publishedRecords();
+
+/**
+ * @brief Marks the ring closed for the consumers, unmaps it and removes its name
+ */
+void closePublisher();
+
+#endif
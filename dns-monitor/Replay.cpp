@@ -0,0 +1,215 @@
+#include "Replay.h"
+#include "Batch.h"
+#include "Format.h"
+#include "LoadShed.h"
+#include "Capture.h"
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+struct replayStats {
+    bool active;
+    double speed;
+    uint64_t packets;
+    uint64_t bytes;
+    int64_t elapsed_ns;
+    int64_t max_lag_ns;
+    uint64_t late;             // packets over REPLAY_DROP_LAG_MS
+    int64_t first_drop_ns;     // replay time of the first late packet, -1 when none
+    uint64_t first_drop_rate;  // packets per second offered just before it
+};
+
+static replayStats replay_stats;
+static int64_t replay_start = 0;
+
+static inline int64_t monotonicNs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static inline int64_t packetNs(const struct timeval &ts)
+{
+    return (int64_t)ts.tv_sec * 1000000000 + (int64_t)ts.tv_usec * 1000;
+}
+
+bool parseReplaySpeed(const std::string &text, double &speed)
+{
+    if (text == "max")
+    {
+        speed = 0;
+        return true;
+    }
+    char *end;
+    speed = std::strtod(text.c_str(), &end);
+    return end != text.c_str() && *end == '\0' && speed > 0;
+}
+
+int runReplay(pcap_t *handle, double speed, unsigned loops, pcap_handler handler, u_char *user)
+{
+    // everything is in memory first, so reading the file is not part of the measurement
+    std::vector<struct pcap_pkthdr> headers;
+    std::vector<size_t> offsets;
+    std::vector<u_char> data;
+    struct pcap_pkthdr *header;
+    const u_char *packet;
+    int result;
+    while ((result = pcap_next_ex(handle, &header, &packet)) == 1)
+    {
+        headers.push_back(*header);
+        offsets.push_back(data.size());
+        data.insert(data.end(), packet, packet + header->caplen);
+    }
+    if (result == PCAP_ERROR)
+    {
+        std::cerr << "Error while loading the pcap file: " << pcap_geterr(handle) << std::endl;
+        return 1;
+    }
+    if (headers.empty())
+    {
+        return 0;
+    }
+
+    // looped copies follow the previous one a millisecond after its last packet
+    int64_t first_ns = packetNs(headers.front().ts);
+    int64_t loop_ns = packetNs(headers.back().ts) - first_ns + 1000000;
+
+    std::memset(&replay_stats, 0, sizeof(replay_stats));
+    replay_stats.active = true;
+    replay_stats.speed = speed;
+    replay_stats.first_drop_ns = -1;
+    replay_start = monotonicNs();
+
+    // due times of the packets of the last second, for the offered rate at the first drop
+    std::deque<int64_t> recent;
+    int64_t drop_lag = (int64_t)REPLAY_DROP_LAG_MS * 1000000;
+
+    // one progress line per second, so the point where the lag starts to grow is visible
+    int64_t next_report = 1000000000;
+    uint64_t reported_packets = 0;
+    uint64_t interval_late = 0;
+    int64_t interval_lag = 0;
+
+    for (unsigned loop = 0; (loops == 0 || loop < loops) && !captureStopped(); loop++)
+    {
+        for (size_t i = 0; i < headers.size() && !captureStopped(); i++)
+        {
+            struct pcap_pkthdr shifted = headers[i];
+            int64_t offset_ns = (int64_t)loop * loop_ns;
+            int64_t ts_ns = packetNs(shifted.ts) + offset_ns;
+            shifted.ts.tv_sec = ts_ns / 1000000000;
+            shifted.ts.tv_usec = (ts_ns % 1000000000) / 1000;
+
+            if (speed > 0)
+            {
+                int64_t due = (int64_t)((ts_ns - first_ns) / speed);
+                int64_t now = monotonicNs() - replay_start;
+                if (due > now)
+                {
+                    // the pipeline is idle until the packet is due, like a live capture between bursts
+                    reportLag(0);
+                    flushBatch();
+                    flushOutput(standard_output);
+                    struct timespec wake;
+                    int64_t wake_ns = replay_start + due;
+                    wake.tv_sec = wake_ns / 1000000000;
+                    wake.tv_nsec = wake_ns % 1000000000;
+                    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, nullptr) != 0 && !captureStopped())
+                    {
+                    }
+                }
+                else
+                {
+                    int64_t lag = now - due;
+                    reportLag(lag);
+                    if (lag > replay_stats.max_lag_ns)
+                    {
+                        replay_stats.max_lag_ns = lag;
+                    }
+                    if (lag > interval_lag)
+                    {
+                        interval_lag = lag;
+                    }
+                    if (lag > drop_lag)
+                    {
+                        interval_late++;
+                        if (replay_stats.late++ == 0)
+                        {
+                            replay_stats.first_drop_ns = due;
+                            // rate over the last second, or over the replay so far when it is shorter
+                            int64_t span = due < 1000000000 ? due : 1000000000;
+                            replay_stats.first_drop_rate = span > 0 ? (uint64_t)(recent.size() * 1e9 / span) : recent.size();
+                        }
+                    }
+                }
+                // only needed until the first drop
+                if (replay_stats.first_drop_ns < 0)
+                {
+                    while (!recent.empty() && recent.front() < due - 1000000000)
+                    {
+                        recent.pop_front();
+                    }
+                    recent.push_back(due);
+                }
+            }
+
+            if ((replay_stats.packets & (PACKET_BATCH - 1)) == 0 && monotonicNs() - replay_start >= next_report)
+            {
+                std::cerr << "Replay " << next_report / 1000000000 << " s: " << replay_stats.packets - reported_packets << " packets/s";
+                if (speed > 0)
+                {
+                    std::cerr << ", max lag " << interval_lag / 1000000.0 << " ms, " << interval_late << " late";
+                }
+                std::cerr << std::endl;
+                next_report += 1000000000;
+                reported_packets = replay_stats.packets;
+                interval_late = 0;
+                interval_lag = 0;
+            }
+
+            handler(user, &shifted, data.data() + offsets[i]);
+            replay_stats.packets++;
+            replay_stats.bytes += shifted.len;
+        }
+    }
+
+    flushBatch();
+    replay_stats.elapsed_ns = monotonicNs() - replay_start;
+    return 0;
+}
+
+void printReplayReport()
+{
+    if (!replay_stats.active)
+    {
+        return;
+    }
+    // interrupted replays report up to now
+    int64_t elapsed = replay_stats.elapsed_ns != 0 ? replay_stats.elapsed_ns : monotonicNs() - replay_start;
+    double seconds = elapsed / 1e9;
+    if (seconds <= 0)
+    {
+        seconds = 1e-9;
+    }
+
+    std::cerr << "Replay: " << replay_stats.packets << " packets in " << seconds << " s, "
+              << (uint64_t)(replay_stats.packets / seconds) << " packets/s, "
+              << replay_stats.bytes * 8 / seconds / 1e6 << " Mbit/s" << std::endl;
+    if (replay_stats.speed == 0)
+    {
+        return;
+    }
+    std::cerr << "Replay speed " << replay_stats.speed << "x, max lag " << replay_stats.max_lag_ns / 1000000.0 << " ms" << std::endl;
+    if (replay_stats.late == 0)
+    {
+        std::cerr << "No packet over " << REPLAY_DROP_LAG_MS << " ms late" << std::endl;
+        return;
+    }
+    std::cerr << replay_stats.late << " packets over " << REPLAY_DROP_LAG_MS << " ms late, first after "
+              << replay_stats.first_drop_ns / 1e9 << " s at " << replay_stats.first_drop_rate << " packets/s offered" << std::endl;
+}
@@ -0,0 +1,39 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <pcap.h>
+#include <string>
+
+#define REPLAY_DROP_LAG_MS 100 // lag at which a live capture buffer would start dropping
+
+/*
+ * Replay of a pcap file through the whole pipeline for capacity planning. The file is
+ * loaded into memory, then fed to the handler at the original rate, N times faster or as
+ * fast as possible, optionally in a loop. Looped copies are shifted in time so windows
+ * and the dedup filter see fresh traffic.
+ *
+ * In timed modes every packet has its due time; how late the pipeline is when it gets to
+ * the packet is its lag. Packets with a lag over REPLAY_DROP_LAG_MS would have been
+ * dropped by a live capture, the report shows when that first happened and at what rate.
+ */
+
+/**
+ * @brief Parses the speed, "max" or a positive multiplier of the original rate
+ *
+ * @param speed 0 for max
+ */
+bool parseReplaySpeed(const std::string &text, double &speed);
+
+/**
+ * @brief Replays the packets of an opened pcap file
+ *
+ * @param speed multiplier of the original rate, 0 for as fast as possible
+ * @param loops how many times the file is played, 0 until interrupted
+ * @return exit code for main
+ */
+int runReplay(pcap_t *handle, double speed, unsigned loops, pcap_handler handler, u_char *user);
+
+// Prints the throughput and lag summary, nothing when no replay ran
+void printReplayReport();
+
+#endif
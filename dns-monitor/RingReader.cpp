@@ -0,0 +1,105 @@
+#include "RingReader.h"
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+bool openRingReader(dnsRingReader &reader, const std::string &name, bool from_start)
+{
+    std::string path = name[0] == '/' ? name : "/" + name;
+    int fd = shm_open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        std::cerr << "Could not open shared memory " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(dnsRingHeader))
+    {
+        std::cerr << "Shared memory " << path << " is not a dns-monitor ring" << std::endl;
+        close(fd);
+        return false;
+    }
+    void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "Could not map shared memory " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    dnsRingHeader *header = (dnsRingHeader *)mapping;
+    bool valid = std::memcmp(header->magic, DNS_RING_MAGIC, sizeof(header->magic)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    valid = valid && header->slot_size == sizeof(dnsRingSlot) &&
+            header->slot_count != 0 && (header->slot_count & (header->slot_count - 1)) == 0 &&
+            (size_t)info.st_size >= ringSize(header->slot_count);
+    if (!valid)
+    {
+        std::cerr << "Shared memory " << path << " is not a dns-monitor ring of this version" << std::endl;
+        munmap(mapping, info.st_size);
+        return false;
+    }
+
+    reader.header = header;
+    reader.mapping_size = info.st_size;
+    reader.lost = 0;
+    uint64_t written = header->write_sequence.load(std::memory_order_acquire);
+    reader.next = written + 1;
+    if (from_start)
+    {
+        reader.next = written > header->slot_count ? written - header->slot_count + 1 : 1;
+    }
+    return true;
+}
+
+RING_READ_RESULT readRingRecord(dnsRingReader &reader, dnsRingRecord &record)
+{
+    dnsRingHeader *header = reader.header;
+    for (;;)
+    {
+        // closed is checked first, so the records published before it are still read
+        bool closed = header->closed.load(std::memory_order_acquire) != 0;
+        uint64_t written = header->write_sequence.load(std::memory_order_acquire);
+        if (reader.next > written)
+        {
+            return closed ? RING_CLOSED : RING_EMPTY;
+        }
+        // the producer is more than a ring ahead, the oldest slot still valid is written - slot_count + 1
+        if (written - reader.next >= header->slot_count)
+        {
+            uint64_t oldest = written - header->slot_count + 1;
+            reader.lost += oldest - reader.next;
+            reader.next = oldest;
+        }
+
+        const dnsRingSlot &slot = ringSlots(header)[reader.next & (header->slot_count - 1)];
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before == reader.next)
+        {
+            std::memcpy(&record, &slot.record, sizeof(record));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == before)
+            {
+                reader.next++;
+                return RING_RECORD;
+            }
+        }
+        // overwritten while we looked at it, the next pass skips to the oldest record
+        reader.lost++;
+        reader.next++;
+    }
+}
+
+void closeRingReader(dnsRingReader &reader)
+{
+    if (reader.header != nullptr)
+    {
+        munmap(reader.header, reader.mapping_size);
+        reader.header = nullptr;
+    }
+}
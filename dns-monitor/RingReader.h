@@ -0,0 +1,48 @@
+#ifndef RINGREADER_H
+#define RINGREADER_H
+
+#include "DnsRing.h"
+
+#include <cstddef>
+#include <string>
+
+/*
+ * Consumer side of the ring published by dns-monitor --publish. Each reader keeps its
+ * own position, so any number of them can attach and read at their own pace. A reader
+ * that falls more than a ring behind loses the oldest records, readRingRecord then
+ * continues with the oldest record still available and adds the gap to lost.
+ *
+ * Build with RingReader.cpp and -lrt, see dns-ring-reader.cpp (make reader) for an example.
+ */
+
+struct dnsRingReader {
+    dnsRingHeader *header;
+    size_t mapping_size;
+    uint64_t next; // sequence of the next record to read
+    uint64_t lost; // records overwritten before they were read
+};
+
+enum RING_READ_RESULT
+{
+    RING_RECORD,  // record was filled
+    RING_EMPTY,   // nothing new yet
+    RING_CLOSED   // the producer exited and everything was read
+};
+
+/**
+ * @brief Attaches to a ring
+ *
+ * @param name shared memory name given to --publish
+ * @param from_start read the records still in the ring first instead of only new ones
+ * @return false if the ring does not exist or has another layout
+ */
+bool openRingReader(dnsRingReader &reader, const std::string &name, bool from_start = false);
+
+/**
+ * @brief Copies the next record without waiting
+ */
+RING_READ_RESULT readRingRecord(dnsRingReader &reader, dnsRingRecord &record);
+
+void closeRingReader(dnsRingReader &reader);
+
+#endif
@@ -0,0 +1,68 @@
+#include "Trace.h"
+
+#ifdef DNS_MONITOR_TRACE
+
+#include <iostream>
+
+#define TRACE_BUCKETS 64 // bucket i holds durations in [2^(i-1), 2^i)
+
+struct stageHistogram {
+    uint64_t buckets[TRACE_BUCKETS];
+    uint64_t count;
+    uint64_t total;
+};
+
+static stageHistogram histograms[TRACE_STAGE_COUNT];
+
+static const char *stage_names[TRACE_STAGE_COUNT] = {"decode", "question", "sections", "output", "aggregate"};
+
+void traceRecord(int stage, uint64_t cycles)
+{
+    stageHistogram &histogram = histograms[stage];
+    int bucket = cycles == 0 ? 0 : 64 - __builtin_clzll(cycles);
+    histogram.buckets[bucket < TRACE_BUCKETS ? bucket : TRACE_BUCKETS - 1]++;
+    histogram.count++;
+    histogram.total += cycles;
+}
+
+// upper bound of the bucket that contains the given quantile
+static uint64_t quantile(const stageHistogram &histogram, double q)
+{
+    uint64_t rank = (uint64_t)(histogram.count * q);
+    uint64_t seen = 0;
+    for (int i = 0; i < TRACE_BUCKETS; i++)
+    {
+        seen += histogram.buckets[i];
+        if (seen > rank)
+        {
+            return i == 0 ? 0 : (i >= 63 ? UINT64_MAX : (1ULL << i) - 1);
+        }
+    }
+    return 0;
+}
+
+void printTraceReport()
+{
+    std::cerr << "Stage timing (cycles):" << std::endl;
+    for (int stage = 0; stage < TRACE_STAGE_COUNT; stage++)
+    {
+        const stageHistogram &histogram = histograms[stage];
+        if (histogram.count == 0)
+        {
+            continue;
+        }
+        std::cerr << "  " << stage_names[stage] << ": count=" << histogram.count
+                  << " mean=" << histogram.total / histogram.count
+                  << " p50<=" << quantile(histogram, 0.5)
+                  << " p99<=" << quantile(histogram, 0.99) << std::endl;
+        for (int i = 0; i < TRACE_BUCKETS; i++)
+        {
+            if (histogram.buckets[i] != 0)
+            {
+                std::cerr << "    <" << (i >= 63 ? UINT64_MAX : (1ULL << i)) << ": " << histogram.buckets[i] << std::endl;
+            }
+        }
+    }
+}
+
+#endif
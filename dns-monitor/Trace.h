@@ -0,0 +1,93 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+
+/*
+ * Optional per-stage instrumentation of the packet processing, enabled by building with
+ * -DDNS_MONITOR_TRACE (make trace). Every stage is timed with the cycle counter,
+ * aggregated into a log2 histogram and reported at exit. When <sys/sdt.h> is
+ * available, every stage also fires a USDT probe dns_monitor:<stage> with the
+ * cycle count as its argument, e.g.
+ *
+ *   bpftrace -e 'usdt:./dns-monitor:dns_monitor:sections { @ = hist(arg0); }'
+ *
+ * Phases that run over a whole batch record the average number of cycles per packet.
+ * Without the flag all the macros expand to nothing.
+ */
+
+enum TRACE_STAGE
+{
+    TRACE_DECODE,    // L2/L3/L4 headers, once per batch
+    TRACE_QUESTION,  // question section
+    TRACE_SECTIONS,  // answer, authority and additional sections
+    TRACE_OUTPUT,    // text output
+    TRACE_AGGREGATE, // statistics windows, once per batch
+    TRACE_STAGE_COUNT
+};
+
+#ifdef DNS_MONITOR_TRACE
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t traceCycles()
+{
+    return __rdtsc();
+}
+#else
+#include <ctime>
+// no portable cycle counter, nanoseconds are the closest substitute
+static inline uint64_t traceCycles()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+#endif
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define TRACE_PROBE(probe, cycles) DTRACE_PROBE1(dns_monitor, probe, cycles)
+#endif
+#endif
+#ifndef TRACE_PROBE
+#define TRACE_PROBE(probe, cycles) do { } while (0)
+#endif
+
+void traceRecord(int stage, uint64_t cycles);
+void printTraceReport();
+
+#define TRACE_BEGIN() uint64_t trace_last = traceCycles()
+#define TRACE_RESTART() trace_last = traceCycles()
+#define TRACE_STAGE(stage, probe)                        \
+    do                                                   \
+    {                                                    \
+        uint64_t trace_now = traceCycles();              \
+        traceRecord(stage, trace_now - trace_last);      \
+        TRACE_PROBE(probe, trace_now - trace_last);      \
+        trace_last = trace_now;                          \
+    } while (0)
+// phase that ran over a whole batch, recorded as the average per packet
+#define TRACE_BATCH_STAGE(stage, probe, packets)                         \
+    do                                                                   \
+    {                                                                    \
+        uint64_t trace_now = traceCycles();                              \
+        if ((packets) > 0)                                               \
+        {                                                                \
+            traceRecord(stage, (trace_now - trace_last) / (packets));    \
+            TRACE_PROBE(probe, (trace_now - trace_last) / (packets));    \
+        }                                                                \
+        trace_last = trace_now;                                          \
+    } while (0)
+
+#else
+
+#define TRACE_BEGIN()
+#define TRACE_RESTART() do { } while (0)
+#define TRACE_STAGE(stage, probe) do { } while (0)
+#define TRACE_BATCH_STAGE(stage, probe, packets) do { } while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,383 @@
+#include "Watchlist.h"
+#include "Affinity.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+#include <csignal>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define WATCHLIST_MAGIC "DNSWL01"
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static std::atomic<watchlistTable *> active_table(nullptr);
+// odd while the capture thread is between beginWatchlistUse and endWatchlistUse
+static std::atomic<uint64_t> use_sequence(0);
+
+static inline unsigned char lowerChar(unsigned char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c | 0x20 : c;
+}
+
+// slot key for a hash, the low bits carry the flags and 0 marks an empty slot
+static inline uint64_t slotKey(uint64_t hash)
+{
+    uint64_t key = hash & ~(uint64_t)WATCHLIST_FLAGS;
+    return key == 0 ? WATCHLIST_FLAGS + 1 : key;
+}
+
+static inline uint64_t slotIndex(uint64_t key, uint64_t mask)
+{
+    return (key ^ (key >> 32)) & mask;
+}
+
+// hash of the whole name, computed from the last character to the first
+static uint64_t reverseHash(const char *name, size_t length)
+{
+    uint64_t hash = FNV_OFFSET;
+    for (size_t i = length; i-- > 0;)
+    {
+        hash = (hash ^ lowerChar(name[i])) * FNV_PRIME;
+    }
+    return hash;
+}
+
+static inline int probe(const watchlistTable *table, uint64_t hash)
+{
+    uint64_t key = slotKey(hash);
+    for (uint64_t i = slotIndex(key, table->mask);; i = (i + 1) & table->mask)
+    {
+        uint64_t slot = table->slots[i];
+        if (slot == 0)
+        {
+            return 0;
+        }
+        if ((slot & ~(uint64_t)WATCHLIST_FLAGS) == key)
+        {
+            return slot & WATCHLIST_FLAGS;
+        }
+    }
+}
+
+int matchWatchlist(const watchlistTable *table, const char *name, size_t length)
+{
+    uint64_t hash = FNV_OFFSET;
+
+    for (size_t i = length; i-- > 0;)
+    {
+        unsigned char c = lowerChar(name[i]);
+        // hash now covers the suffix after this dot
+        if (c == '.' && (probe(table, hash) & WATCHLIST_SUFFIX))
+        {
+            return WATCHLIST_SUFFIX;
+        }
+        hash = (hash ^ c) * FNV_PRIME;
+    }
+
+    int flags = probe(table, hash);
+    if (flags & WATCHLIST_EXACT)
+    {
+        return WATCHLIST_EXACT;
+    }
+    return flags & WATCHLIST_SUFFIX;
+}
+
+static void insertSlot(uint64_t *slots, uint64_t mask, uint64_t hash, int flags, uint64_t &entry_count)
+{
+    uint64_t key = slotKey(hash);
+    for (uint64_t i = slotIndex(key, mask);; i = (i + 1) & mask)
+    {
+        if (slots[i] == 0)
+        {
+            slots[i] = key | flags;
+            entry_count++;
+            return;
+        }
+        if ((slots[i] & ~(uint64_t)WATCHLIST_FLAGS) == key)
+        {
+            slots[i] |= flags;
+            return;
+        }
+    }
+}
+
+// parses the text list into hashes with their flags in the low bits
+static bool readRules(const std::string &path, std::vector<uint64_t> &rules)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Could not open watchlist " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        size_t begin = line.find_first_not_of(" \t");
+        if (begin == std::string::npos || line[begin] == '#')
+        {
+            continue;
+        }
+        size_t end = line.find_first_of(" \t\r#", begin);
+        if (end == std::string::npos)
+        {
+            end = line.size();
+        }
+
+        int flags = WATCHLIST_EXACT;
+        if (line.compare(begin, 2, "*.") == 0)
+        {
+            begin += 2;
+            flags = WATCHLIST_SUFFIX;
+        }
+        else if (line[begin] == '.')
+        {
+            begin++;
+            flags = WATCHLIST_SUFFIX;
+        }
+        // names in queries are matched without the root dot
+        if (end > begin && line[end - 1] == '.')
+        {
+            end--;
+        }
+        if (end <= begin)
+        {
+            continue;
+        }
+
+        rules.push_back(slotKey(reverseHash(line.data() + begin, end - begin)) | flags);
+    }
+    return true;
+}
+
+static int64_t modificationTime(const struct stat &source)
+{
+    return (int64_t)source.st_mtim.tv_sec * 1000000000 + source.st_mtim.tv_nsec;
+}
+
+static watchlistTable *mapImage(const std::string &image_path, const struct stat &source)
+{
+    int fd = open(image_path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    struct stat image;
+    if (fstat(fd, &image) != 0 || (size_t)image.st_size < sizeof(watchlistImageHeader))
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    void *mapping = mmap(nullptr, image.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    const watchlistImageHeader *header = (const watchlistImageHeader *)mapping;
+    bool valid = std::memcmp(header->magic, WATCHLIST_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->slot_count != 0 && (header->slot_count & (header->slot_count - 1)) == 0 &&
+                 (uint64_t)image.st_size == sizeof(watchlistImageHeader) + header->slot_count * sizeof(uint64_t) &&
+                 header->source_size == (uint64_t)source.st_size &&
+                 header->source_mtime == modificationTime(source);
+    if (!valid)
+    {
+        munmap(mapping, image.st_size);
+        return nullptr;
+    }
+
+    watchlistTable *table = new watchlistTable();
+    table->slots = (const uint64_t *)(header + 1);
+    table->mask = header->slot_count - 1;
+    table->entry_count = header->entry_count;
+    table->mapping = mapping;
+    table->mapping_size = image.st_size;
+    table->owned = nullptr;
+    return table;
+}
+
+// writes the image atomically, a failure only means the next start has to rebuild it
+static void saveImage(const std::string &image_path, const watchlistImageHeader &header, const uint64_t *slots)
+{
+    std::string tmp_path = image_path + ".tmp";
+    FILE *file = std::fopen(tmp_path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        return;
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(slots, sizeof(uint64_t), header.slot_count, file) == header.slot_count;
+    if (std::fclose(file) != 0 || !written || std::rename(tmp_path.c_str(), image_path.c_str()) != 0)
+    {
+        std::remove(tmp_path.c_str());
+    }
+}
+
+watchlistTable *loadWatchlist(const std::string &path)
+{
+    struct stat source;
+    if (stat(path.c_str(), &source) != 0)
+    {
+        std::cerr << "Could not open watchlist " << path << std::endl;
+        return nullptr;
+    }
+
+    std::string image_path = path + ".bin";
+    watchlistTable *table = mapImage(image_path, source);
+    if (table != nullptr)
+    {
+        return table;
+    }
+
+    std::vector<uint64_t> rules;
+    if (!readRules(path, rules))
+    {
+        return nullptr;
+    }
+
+    // keep the load factor at or below one half so probe sequences stay short
+    uint64_t slot_count = 16;
+    while (slot_count < rules.size() * 2)
+    {
+        slot_count <<= 1;
+    }
+
+    uint64_t *slots = new uint64_t[slot_count]();
+    uint64_t entry_count = 0;
+    for (size_t i = 0; i < rules.size(); i++)
+    {
+        insertSlot(slots, slot_count - 1, rules[i], rules[i] & WATCHLIST_FLAGS, entry_count);
+    }
+
+    watchlistImageHeader header;
+    std::memcpy(header.magic, WATCHLIST_MAGIC, sizeof(header.magic));
+    header.slot_count = slot_count;
+    header.entry_count = entry_count;
+    header.source_size = source.st_size;
+    header.source_mtime = modificationTime(source);
+    saveImage(image_path, header, slots);
+
+    table = mapImage(image_path, source);
+    if (table != nullptr)
+    {
+        delete[] slots;
+        return table;
+    }
+
+    table = new watchlistTable();
+    table->slots = slots;
+    table->mask = slot_count - 1;
+    table->entry_count = entry_count;
+    table->mapping = nullptr;
+    table->mapping_size = 0;
+    table->owned = slots;
+    return table;
+}
+
+void freeWatchlist(watchlistTable *table)
+{
+    if (table == nullptr)
+    {
+        return;
+    }
+    if (table->mapping != nullptr)
+    {
+        munmap(table->mapping, table->mapping_size);
+    }
+    delete[] table->owned;
+    delete table;
+}
+
+const watchlistTable *activeWatchlist()
+{
+    return active_table.load(std::memory_order_seq_cst);
+}
+
+void beginWatchlistUse()
+{
+    // sequentially consistent, so either the reload sees the odd value or this thread sees the new table
+    use_sequence.fetch_add(1, std::memory_order_seq_cst);
+}
+
+void endWatchlistUse()
+{
+    use_sequence.fetch_add(1, std::memory_order_release);
+}
+
+// grace period of a replaced table, returns once no lookup can still hold it
+static void waitForWatchlistUsers()
+{
+    uint64_t sequence = use_sequence.load(std::memory_order_seq_cst);
+    if ((sequence & 1) == 0)
+    {
+        return;
+    }
+    // the batch that might have loaded the old table has to end, later ones load the new one
+    while (use_sequence.load(std::memory_order_acquire) == sequence)
+    {
+        usleep(WATCHLIST_GRACE_POLL_US);
+    }
+}
+
+// waits for SIGHUP and swaps in a freshly loaded table
+static void reloadLoop(std::string path, sigset_t reload_set)
+{
+    // this thread only handles SIGHUP, the rest goes to the capture thread
+    sigset_t all;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, nullptr);
+    pinWorkerThread();
+
+    for (;;)
+    {
+        int signum;
+        if (sigwait(&reload_set, &signum) != 0)
+        {
+            continue;
+        }
+
+        watchlistTable *table = loadWatchlist(path);
+        if (table == nullptr)
+        {
+            std::cerr << "Watchlist reload failed, keeping the previous one" << std::endl;
+            continue;
+        }
+
+        watchlistTable *retired = active_table.exchange(table, std::memory_order_seq_cst);
+        waitForWatchlistUsers();
+        freeWatchlist(retired);
+        std::cerr << "Watchlist reloaded: " << table->entry_count << " entries" << std::endl;
+    }
+}
+
+bool initWatchlist(const std::string &path)
+{
+    sigset_t reload_set;
+    sigemptyset(&reload_set);
+    sigaddset(&reload_set, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &reload_set, nullptr);
+
+    watchlistTable *table = loadWatchlist(path);
+    if (table == nullptr)
+    {
+        return false;
+    }
+    active_table.store(table, std::memory_order_release);
+    std::cerr << "Watchlist loaded: " << table->entry_count << " entries" << std::endl;
+
+    std::thread(reloadLoop, path, reload_set).detach();
+    return true;
+}
@@ -0,0 +1,80 @@
+#ifndef WATCHLIST_H
+#define WATCHLIST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Flags stored in the low bits of every watchlist slot
+#define WATCHLIST_EXACT 0x1  // the name itself is listed
+#define WATCHLIST_SUFFIX 0x2 // the name and all its subdomains are listed
+#define WATCHLIST_FLAGS 0x3
+
+#define WATCHLIST_GRACE_POLL_US 1000 // how often a reload checks whether the old table is still in use
+
+/*
+ * The watchlist is a suffix hash: every listed name is stored as a 64-bit hash of its
+ * characters (lowercased, hashed from the last character to the first) in an open
+ * addressing table. Hashing from the right lets a lookup compute the hashes of all
+ * suffixes of a query name in one pass, probing the table once per label.
+ *
+ * The compiled table is saved next to the text list as <file>.bin and memory-mapped
+ * on the next start, so restarts do not have to parse the text list again.
+ *
+ * A reload swaps the table pointer and frees the old table only after a grace period:
+ * the capture thread brackets every batch with beginWatchlistUse/endWatchlistUse, and
+ * the reload waits until the batch that was running during the swap has ended.
+ */
+
+#pragma pack(push, 1)
+struct watchlistImageHeader {
+    char magic[8];
+    uint64_t slot_count;   // power of two
+    uint64_t entry_count;
+    uint64_t source_size;  // size and mtime of the text list the image was built from
+    int64_t source_mtime; // nanoseconds
+};
+#pragma pack(pop)
+
+struct watchlistTable {
+    const uint64_t *slots;
+    uint64_t mask;
+    uint64_t entry_count;
+    void *mapping;       // whole image when the table is memory-mapped, nullptr otherwise
+    size_t mapping_size;
+    uint64_t *owned;     // heap copy when the table was built and could not be mapped
+};
+
+/**
+ * @brief Loads the watchlist, using the compiled image when it is up to date
+ *
+ * @param path text list, one domain per line, ".domain" or "*.domain" for suffixes, '#' comments
+ * @return table or nullptr on error
+ */
+watchlistTable *loadWatchlist(const std::string &path);
+
+void freeWatchlist(watchlistTable *table);
+
+/**
+ * @brief Looks up a domain name and all its parent domains
+ *
+ * @return WATCHLIST_EXACT or WATCHLIST_SUFFIX for the rule that matched, 0 otherwise
+ */
+int matchWatchlist(const watchlistTable *table, const char *name, size_t length);
+
+/**
+ * @brief Loads the watchlist and starts the thread that reloads it on SIGHUP
+ *
+ * Must be called before any other thread is started, SIGHUP is blocked in the calling thread.
+ */
+bool initWatchlist(const std::string &path);
+
+// Table currently in use, nullptr when no watchlist is configured
+const watchlistTable *activeWatchlist();
+
+// Brackets the lookups of one batch, a table loaded in between is not freed before the end
+void beginWatchlistUse();
+
+void endWatchlistUse();
+
+#endif
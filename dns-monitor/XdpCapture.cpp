@@ -0,0 +1,320 @@
+#include "XdpCapture.h"
+#include "Format.h"
+#include "Batch.h"
+#include "Affinity.h"
+#include "Capture.h"
+
+#include <iostream>
+
+#ifdef DNS_MONITOR_XDP
+
+#include <vector>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <poll.h>
+#include <net/if.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/if_xdp.h>
+#include <bpf/libbpf.h>
+#include <xdp/libxdp.h>
+#include <xdp/xsk.h>
+
+struct xdpQueue {
+    unsigned queue;
+    void *umem_area;
+    struct xsk_umem *umem;
+    struct xsk_ring_prod fill;
+    struct xsk_ring_cons completion;
+    struct xsk_socket *socket;
+    struct xsk_ring_cons rx;
+    bool zero_copy;
+};
+
+struct xdpState {
+    int ifindex;
+    enum xdp_attach_mode mode;
+    struct xdp_program *program;
+    std::vector<xdpQueue *> queues;
+};
+
+static xdpState *active_state = nullptr;
+
+static void destroyQueue(xdpQueue *queue)
+{
+    if (queue->socket != nullptr)
+    {
+        xsk_socket__delete(queue->socket);
+    }
+    if (queue->umem != nullptr)
+    {
+        xsk_umem__delete(queue->umem);
+    }
+    std::free(queue->umem_area);
+    delete queue;
+}
+
+static void destroyState(xdpState *state)
+{
+    for (size_t i = 0; i < state->queues.size(); i++)
+    {
+        destroyQueue(state->queues[i]);
+    }
+    if (state->program != nullptr)
+    {
+        xdp_program__detach(state->program, state->ifindex, state->mode, 0);
+        xdp_program__close(state->program);
+    }
+    delete state;
+}
+
+// gives all frames of the UMEM to the kernel for receiving
+static bool fillQueue(xdpQueue *queue)
+{
+    uint32_t index;
+    if (xsk_ring_prod__reserve(&queue->fill, XDP_FRAME_COUNT, &index) != XDP_FRAME_COUNT)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < XDP_FRAME_COUNT; i++)
+    {
+        *xsk_ring_prod__fill_addr(&queue->fill, index + i) = (uint64_t)i * XSK_UMEM__DEFAULT_FRAME_SIZE;
+    }
+    xsk_ring_prod__submit(&queue->fill, XDP_FRAME_COUNT);
+    return true;
+}
+
+static xdpQueue *createQueue(const std::string &interface, unsigned queue_id, xdpState *state, int map_fd)
+{
+    xdpQueue *queue = new xdpQueue();
+    queue->queue = queue_id;
+
+    size_t umem_size = (size_t)XDP_FRAME_COUNT * XSK_UMEM__DEFAULT_FRAME_SIZE;
+    if (posix_memalign(&queue->umem_area, getpagesize(), umem_size) != 0)
+    {
+        queue->umem_area = nullptr;
+        std::cerr << "Could not allocate UMEM for queue " << queue_id << std::endl;
+        destroyQueue(queue);
+        return nullptr;
+    }
+    // the NIC writes the frames, keep them on its node
+    bindToCaptureNode(queue->umem_area, umem_size);
+
+    int error = xsk_umem__create(&queue->umem, queue->umem_area, umem_size, &queue->fill, &queue->completion, nullptr);
+    if (error != 0)
+    {
+        queue->umem = nullptr;
+        std::cerr << "Could not create UMEM for queue " << queue_id << ": " << std::strerror(-error) << std::endl;
+        destroyQueue(queue);
+        return nullptr;
+    }
+
+    struct xsk_socket_config config;
+    std::memset(&config, 0, sizeof(config));
+    config.rx_size = XSK_RING_CONS__DEFAULT_NUM_DESCS;
+    config.tx_size = 0;
+    // the program is attached once for all queues in runXdpCapture
+    config.libxdp_flags = XSK_LIBXDP_FLAGS__INHIBIT_PROG_LOAD;
+
+    // zero-copy needs driver support, generic XDP always copies
+    error = -EOPNOTSUPP;
+    if (state->mode != XDP_MODE_SKB)
+    {
+        config.bind_flags = XDP_ZEROCOPY | XDP_USE_NEED_WAKEUP;
+        error = xsk_socket__create(&queue->socket, interface.c_str(), queue_id, queue->umem, &queue->rx, nullptr, &config);
+        queue->zero_copy = error == 0;
+    }
+    if (error != 0)
+    {
+        config.bind_flags = XDP_COPY | XDP_USE_NEED_WAKEUP;
+        error = xsk_socket__create(&queue->socket, interface.c_str(), queue_id, queue->umem, &queue->rx, nullptr, &config);
+    }
+    if (error != 0)
+    {
+        queue->socket = nullptr;
+        std::cerr << "Could not create AF_XDP socket on " << interface << " queue " << queue_id << ": " << std::strerror(-error) << std::endl;
+        destroyQueue(queue);
+        return nullptr;
+    }
+
+    if (xsk_socket__update_xskmap(queue->socket, map_fd) != 0 || !fillQueue(queue))
+    {
+        std::cerr << "Could not register AF_XDP socket of queue " << queue_id << std::endl;
+        destroyQueue(queue);
+        return nullptr;
+    }
+
+    std::cout << "AF_XDP socket on " << interface << " queue " << queue_id << " ("
+              << (queue->zero_copy ? "zero-copy" : "copy") << " mode)" << std::endl;
+    return queue;
+}
+
+// hands one batch of received frames to runBatch and returns them to the fill ring
+static void receiveBatch(xdpQueue *queue)
+{
+    uint32_t rx_index;
+    uint32_t received = xsk_ring_cons__peek(&queue->rx, XDP_BATCH, &rx_index);
+    if (received == 0)
+    {
+        if (xsk_ring_prod__needs_wakeup(&queue->fill))
+        {
+            recvfrom(xsk_socket__fd(queue->socket), nullptr, 0, MSG_DONTWAIT, nullptr, nullptr);
+        }
+        return;
+    }
+
+    // no hardware timestamps, one clock read per batch
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    packetBatch batch;
+    batch.count = received;
+
+    uint32_t fill_index;
+    while (xsk_ring_prod__reserve(&queue->fill, received, &fill_index) != received)
+    {
+        if (xsk_ring_prod__needs_wakeup(&queue->fill))
+        {
+            recvfrom(xsk_socket__fd(queue->socket), nullptr, 0, MSG_DONTWAIT, nullptr, nullptr);
+        }
+    }
+
+    for (uint32_t i = 0; i < received; i++)
+    {
+        const struct xdp_desc *desc = xsk_ring_cons__rx_desc(&queue->rx, rx_index + i);
+        const u_char *packet = (const u_char *)xsk_umem__get_data(queue->umem_area, xsk_umem__add_offset_to_addr(desc->addr));
+
+        batch.headers[i].ts.tv_sec = now.tv_sec;
+        batch.headers[i].ts.tv_usec = now.tv_nsec / 1000;
+        batch.headers[i].caplen = desc->len;
+        batch.headers[i].len = desc->len;
+        batch.packets[i] = packet;
+
+        *xsk_ring_prod__fill_addr(&queue->fill, fill_index + i) = xsk_umem__extract_addr(desc->addr);
+    }
+    runBatch(batch);
+
+    xsk_ring_prod__submit(&queue->fill, received);
+    xsk_ring_cons__release(&queue->rx, received);
+}
+
+int runXdpCapture(const std::string &interface, unsigned queue_count, const std::string &mode)
+{
+    xdpState *state = new xdpState();
+    state->program = nullptr;
+    state->ifindex = if_nametoindex(interface.c_str());
+    if (state->ifindex == 0)
+    {
+        std::cerr << "Unknown interface " << interface << std::endl;
+        delete state;
+        return 1;
+    }
+
+    if (mode == "skb")
+    {
+        state->mode = XDP_MODE_SKB;
+    }
+    else if (mode == "native")
+    {
+        state->mode = XDP_MODE_NATIVE;
+    }
+    else if (mode.empty())
+    {
+        state->mode = XDP_MODE_UNSPEC;
+    }
+    else
+    {
+        std::cerr << "Unknown XDP mode " << mode << ", expected skb or native" << std::endl;
+        delete state;
+        return 1;
+    }
+
+    struct xdp_program *program = xdp_program__open_file(XDP_OBJECT_PATH, "xdp", nullptr);
+    if (libxdp_get_error(program) != 0)
+    {
+        std::cerr << "Could not load XDP program " << XDP_OBJECT_PATH << std::endl;
+        delete state;
+        return 1;
+    }
+    int error = xdp_program__attach(program, state->ifindex, state->mode, 0);
+    if (error != 0)
+    {
+        std::cerr << "Could not attach XDP program to " << interface << ": " << std::strerror(-error) << std::endl;
+        xdp_program__close(program);
+        delete state;
+        return 1;
+    }
+    state->program = program;
+    active_state = state;
+
+    int map_fd = bpf_object__find_map_fd_by_name(xdp_program__bpf_obj(program), "xsks_map");
+    if (map_fd < 0)
+    {
+        std::cerr << "XDP program has no xsks_map" << std::endl;
+        stopXdpCapture();
+        return 1;
+    }
+
+    std::vector<struct pollfd> fds;
+    for (unsigned i = 0; i < queue_count; i++)
+    {
+        xdpQueue *queue = createQueue(interface, i, state, map_fd);
+        if (queue == nullptr)
+        {
+            stopXdpCapture();
+            return 1;
+        }
+        state->queues.push_back(queue);
+
+        struct pollfd fd;
+        fd.fd = xsk_socket__fd(queue->socket);
+        fd.events = POLLIN;
+        fds.push_back(fd);
+    }
+
+    while (!captureStopped())
+    {
+        int ready = poll(fds.data(), fds.size(), XDP_POLL_TIMEOUT_MS);
+        if (ready < 0 && errno != EINTR)
+        {
+            std::cerr << "poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        for (size_t i = 0; i < state->queues.size(); i++)
+        {
+            if (fds[i].revents & POLLIN)
+            {
+                receiveBatch(state->queues[i]);
+            }
+        }
+        flushOutput(standard_output);
+    }
+
+    int result = captureStopped() ? 0 : 1;
+    stopXdpCapture();
+    return result;
+}
+
+void stopXdpCapture()
+{
+    if (active_state != nullptr)
+    {
+        destroyState(active_state);
+        active_state = nullptr;
+    }
+}
+
+#else
+
+int runXdpCapture(const std::string &, unsigned, const std::string &)
+{
+    std::cerr << "dns-monitor was built without AF_XDP support, build it with make xdp" << std::endl;
+    return 1;
+}
+
+void stopXdpCapture()
+{
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef XDPCAPTURE_H
+#define XDPCAPTURE_H
+
+#include <pcap.h>
+#include <string>
+
+#define XDP_FRAME_COUNT 2048 // UMEM frames per queue, as many as the default fill ring holds
+#define XDP_BATCH 64         // descriptors taken from the RX ring at once, at most PACKET_BATCH
+#define XDP_POLL_TIMEOUT_MS 1000
+
+#ifndef XDP_OBJECT_PATH
+#define XDP_OBJECT_PATH "dns-filter.bpf.o"
+#endif
+
+/*
+ * AF_XDP capture backend, built with -DDNS_MONITOR_XDP (make xdp). The XDP program
+ * from dns-filter.bpf.c redirects DNS packets of the first queue_count RX queues to
+ * one AF_XDP socket per queue. Every RX batch is handed to runBatch as pointers straight
+ * into the UMEM, the frames go back to the fill ring only after the batch is processed.
+ *
+ * Redirected packets do not reach the network stack, so the backend is meant for
+ * mirror ports and taps, not for the interface of a resolver that serves the traffic.
+ */
+
+/**
+ * @brief Captures DNS packets from the interface until an error or stopCapture (Capture.h)
+ *
+ * @param mode "skb" for generic XDP (works on veth pairs), "native" for driver XDP,
+ *             empty to let the kernel choose. Zero-copy is used whenever the driver allows it.
+ * @return exit code for main
+ */
+int runXdpCapture(const std::string &interface, unsigned queue_count, const std::string &mode);
+
+// Detaches the XDP program and frees the sockets, safe to call when nothing is attached
+void stopXdpCapture();
+
+#endif
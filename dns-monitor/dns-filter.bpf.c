@@ -0,0 +1,90 @@
+// XDP program of the AF_XDP capture backend: DNS traffic (UDP or TCP port 53) is
+// redirected to the AF_XDP socket bound to the receiving queue, everything else
+// continues to the network stack.
+//
+// clang -O2 -g -target bpf -c dns-filter.bpf.c -o dns-filter.bpf.o
+
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/in.h>
+#include <linux/ip.h>
+#include <linux/ipv6.h>
+#include <linux/tcp.h>
+#include <linux/udp.h>
+#include <bpf/bpf_endian.h>
+#include <bpf/bpf_helpers.h>
+
+#define DNS_PORT 53
+
+struct {
+    __uint(type, BPF_MAP_TYPE_XSKMAP);
+    __uint(max_entries, 64);
+    __type(key, __u32);
+    __type(value, __u32);
+} xsks_map SEC(".maps");
+
+static __always_inline int isDnsPort(void *l4, void *data_end, __u8 protocol)
+{
+    // source and destination port are at the same offsets in UDP and TCP
+    struct udphdr *udp = l4;
+    if (protocol != IPPROTO_UDP && protocol != IPPROTO_TCP)
+    {
+        return 0;
+    }
+    if ((void *)(udp + 1) > data_end)
+    {
+        return 0;
+    }
+    return udp->source == bpf_htons(DNS_PORT) || udp->dest == bpf_htons(DNS_PORT);
+}
+
+SEC("xdp")
+int dns_filter(struct xdp_md *ctx)
+{
+    void *data = (void *)(long)ctx->data;
+    void *data_end = (void *)(long)ctx->data_end;
+
+    struct ethhdr *eth = data;
+    if ((void *)(eth + 1) > data_end)
+    {
+        return XDP_PASS;
+    }
+
+    void *l4 = 0;
+    __u8 protocol = 0;
+
+    if (eth->h_proto == bpf_htons(ETH_P_IP))
+    {
+        struct iphdr *ip = (void *)(eth + 1);
+        if ((void *)(ip + 1) > data_end || ip->ihl < 5)
+        {
+            return XDP_PASS;
+        }
+        l4 = (void *)ip + ip->ihl * 4;
+        protocol = ip->protocol;
+    }
+    else if (eth->h_proto == bpf_htons(ETH_P_IPV6))
+    {
+        struct ipv6hdr *ip6 = (void *)(eth + 1);
+        if ((void *)(ip6 + 1) > data_end)
+        {
+            return XDP_PASS;
+        }
+        l4 = ip6 + 1;
+        protocol = ip6->nexthdr;
+    }
+    else
+    {
+        return XDP_PASS;
+    }
+
+    if (!isDnsPort(l4, data_end, protocol))
+    {
+        return XDP_PASS;
+    }
+
+    // queues without a socket in the map fall back to the stack
+    return bpf_redirect_map(&xsks_map, ctx->rx_queue_index, XDP_PASS);
+}
+
+char _license[] SEC("license") = "GPL";
@@ -1,11 +1,41 @@
 #include "dns-monitor.h"
 #include "ArgumentParser.h"
+#include "MonitorOptions.h"
+#include "Watchlist.h"
+#include "Capture.h"
+#include "Trace.h"
+#include "Aggregates.h"
+#include "XdpCapture.h"
+#include "Format.h"
+#include "PcapIndex.h"
+#include "Checkpoint.h"
+#include "DomainStore.h"
+#include "Batch.h"
+#include "Affinity.h"
+#include "Dedup.h"
+#include "Replay.h"
+#include "AttackDetector.h"
+#include "Compress.h"
+#include "Anonymize.h"
+#include "Publish.h"
+#include "LoadShed.h"
+#include "AliasSet.h"
 
 #define ETHERNET_HEADER_SIZE 14
 #define UDP_HEADER_SIZE 8
 
 pcap_t *global_handle = nullptr;
+std::vector<captureInterface> global_interfaces;
 userArgs global_args;
+monitorOptions global_options;
+monitorCounters global_counters;
+packetArena global_arena;
+nameGraph global_graph;
+aliasSet alias_translations;                 // "alias ip" lines already in translations_file
+compressedSink *domains_sink = nullptr;      // --domains-gz
+compressedSink *translations_sink = nullptr; // --translations-gz
+dnsRingRecord *publish_record = nullptr;     // slot of the message being decoded with --publish
+bool live_lag = false;                       // packet timestamps are wall clock, their age is the capture lag
 
 // fix A, AAAA, NS, MX, SOA, CNAME, SRV
 
@@ -49,29 +79,168 @@ std::string returnClass(uint16_t dns_class)
     }
 }
 
+// domain and translation lines go to the plain file, the compressed one or both
+void writeLine(std::ofstream &file, compressedSink *sink, const char *line, size_t length)
+{
+    if (file.is_open())
+    {
+        file.write(line, length);
+        file << std::endl;
+    }
+    if (sink != nullptr)
+    {
+        sinkWrite(sink, line, length);
+        sinkWrite(sink, "\n", 1);
+    }
+}
+
+void writeLine(std::ofstream &file, compressedSink *sink, const std::string &line)
+{
+    writeLine(file, sink, line.data(), line.size());
+}
+
 void write(std::string domain_name, std::string ip, userArgs *args, bool is_ip)
 {
-    if (args->domains_file.is_open())
+    if (args->domains_file.is_open() || domains_sink != nullptr)
     {
+        // with a store the names written by earlier runs are skipped too
+        if (domainStoreActive())
+        {
+            if (storeInsert(STORE_DOMAIN, domain_name.data(), domain_name.size()))
+            {
+                writeLine(args->domains_file, domains_sink, domain_name);
+            }
+        }
         // if the domain name is not in the set of domain names, print it to the file
-        if (args->domainnamesinfile.find(domain_name) == args->domainnamesinfile.end())
+        else if (args->domainnamesinfile.find(domain_name) == args->domainnamesinfile.end())
         {
-            args->domains_file << domain_name << std::endl;
+            writeLine(args->domains_file, domains_sink, domain_name);
             args->domainnamesinfile.insert(domain_name);
         }
     }
-    if (is_ip && args->translations_file.is_open())
+    if (is_ip && (args->translations_file.is_open() || translations_sink != nullptr))
     {
         if (ip.empty())
         {
             return;
         }
+        if (domainStoreActive())
+        {
+            if (storeInsert(STORE_TRANSLATION, ip.data(), ip.size()))
+            {
+                writeLine(args->translations_file, translations_sink, domain_name + " " + ip);
+            }
+        }
         // if ip not a key in the map, print the domain name and ip to the file
-        if (args->domainToIPs.find(ip) == args->domainToIPs.end())
+        else if (args->domainToIPs.find(ip) == args->domainToIPs.end())
         {
 
             args->domainToIPs[ip] = domain_name;
-            args->translations_file << domain_name << " " << ip << std::endl;
+            writeLine(args->translations_file, translations_sink, domain_name + " " + ip);
+        }
+    }
+}
+
+// translation of a CNAME chain start to an address of its canonical name
+void writeAlias(const char *alias, const char *ip, userArgs *args)
+{
+    if (!args->translations_file.is_open() && translations_sink == nullptr)
+    {
+        return;
+    }
+    // the line is built in the free part of the packet arena, it is not kept there
+    size_t alias_length = std::strlen(alias);
+    size_t ip_length = std::strlen(ip);
+    size_t length = alias_length + 1 + ip_length;
+    if (global_arena.used + length > ARENA_SIZE)
+    {
+        return;
+    }
+    char *line = global_arena.data + global_arena.used;
+    std::memcpy(line, alias, alias_length);
+    line[alias_length] = ' ';
+    std::memcpy(line + alias_length + 1, ip, ip_length);
+
+    bool new_line = domainStoreActive() ? storeInsert(STORE_ALIAS, line, length)
+                                        : aliasInsert(alias_translations, line, length);
+    if (new_line)
+    {
+        writeLine(args->translations_file, translations_sink, line, length);
+    }
+}
+
+// copies a string into the packet arena, nullptr when the arena is full
+const char *arenaCopy(packetArena &arena, const std::string &str)
+{
+    if (arena.used + str.size() + 1 > ARENA_SIZE)
+    {
+        return nullptr;
+    }
+    char *copy = arena.data + arena.used;
+    std::memcpy(copy, str.c_str(), str.size() + 1);
+    arena.used += str.size() + 1;
+    return copy;
+}
+
+void addChainEdge(nameGraph &graph, packetArena &arena, const std::string &owner, const std::string &target)
+{
+    if (graph.edge_count == MAX_CHAIN_EDGES)
+    {
+        return;
+    }
+    nameEdge &edge = graph.edges[graph.edge_count];
+    edge.owner = arenaCopy(arena, owner);
+    edge.target = arenaCopy(arena, target);
+    if (edge.owner != nullptr && edge.target != nullptr)
+    {
+        graph.edge_count++;
+    }
+}
+
+void addChainAddress(nameGraph &graph, packetArena &arena, const std::string &owner, const std::string &ip)
+{
+    if (graph.address_count == MAX_CHAIN_ADDRESSES)
+    {
+        return;
+    }
+    nameAddress &address = graph.addresses[graph.address_count];
+    address.owner = arenaCopy(arena, owner);
+    address.ip = arenaCopy(arena, ip);
+    if (address.owner != nullptr && address.ip != nullptr)
+    {
+        graph.address_count++;
+    }
+}
+
+/**
+ * @brief Attributes every address at the end of a CNAME chain to the name the chain starts with
+ *
+ * The canonical name already got its translation in parseSection, this adds the alias.
+ */
+void resolveChains(const nameGraph &graph, userArgs *args)
+{
+    for (size_t i = 0; i < graph.address_count; i++)
+    {
+        const char *name = graph.addresses[i].owner;
+
+        // walk the chain backwards, the depth limit also stops CNAME loops
+        for (size_t depth = 0; depth < graph.edge_count; depth++)
+        {
+            size_t edge = 0;
+            while (edge < graph.edge_count && strcasecmp(graph.edges[edge].target, name) != 0)
+            {
+                edge++;
+            }
+            if (edge == graph.edge_count)
+            {
+                break;
+            }
+            name = graph.edges[edge].owner;
+        }
+
+        if (name != graph.addresses[i].owner)
+        {
+            writeAlias(name, graph.addresses[i].ip, args);
         }
     }
 }
@@ -135,8 +304,34 @@ int calculateDomainLength(const u_char *packet, int offset, int dns_header_offse
     return domain_length;
 }
 
-void parseQuestion(const u_char *packet, int &offset, int record_count, userArgs *args, int dns_header_offset, std::string &question_section)
+// fills the message info and the published record from the first question
+void noteFirstQuestion(const std::string &domain_name, const dnsQuestion &question, dnsMessageInfo &info)
+{
+    info.qtype = ntohs(question.qtype);
+    if (detectorActive())
+    {
+        describeQuestion(info, domain_name);
+    }
+    if (publish_record != nullptr)
+    {
+        size_t length = std::min(domain_name.size(), (size_t)DNS_RING_NAME_LENGTH - 1);
+        std::memcpy(publish_record->qname, domain_name.data(), length);
+        publish_record->qname[length] = '\0';
+        publish_record->qname_length = length;
+        publish_record->qclass = ntohs(question.qclass);
+    }
+}
+
+/**
+ * @brief Parses the question section
+ *
+ * @return number of question names that matched the watchlist
+ */
+int parseQuestion(const u_char *packet, int &offset, int record_count, userArgs *args, int dns_header_offset, std::string &question_section, dnsMessageInfo &info)
 {
+    const watchlistTable *watchlist = activeWatchlist();
+    int watchlist_matches = 0;
+
     for (int i = 0; i < record_count; i++)
     {
         std::string domain_name;
@@ -148,17 +343,99 @@ void parseQuestion(const u_char *packet, int &offset, int record_count, userArgs
 
         offset += sizeof(dnsQuestion);
 
+        if (i == 0)
+        {
+            noteFirstQuestion(domain_name, question, info);
+        }
 
         // Convert the qtype and qclass to string
         std::string qtype_str = returnType(ntohs(question.qtype));
         std::string qclass_str = returnClass(ntohs(question.qclass));
 
-        question_section += domain_name + " " + qclass_str + " " + qtype_str + "\n";
+        question_section += domain_name + " " + qclass_str + " " + qtype_str;
+        if (watchlist != nullptr && matchWatchlist(watchlist, domain_name.data(), domain_name.size()))
+        {
+            watchlist_matches++;
+            question_section += " [watchlist]";
+        }
+        question_section += "\n";
         write(domain_name, "", args, false);
     }
+    global_counters.watchlist_matches += watchlist_matches;
+    return watchlist_matches;
 }
 
-void parseSection(const u_char *packet, int &offset, int record_count, userArgs *args, int dns_header_offset, std::string &section)
+/**
+ * @brief Decodes the EDNS(0) OPT pseudo-record and its client subnet option
+ *
+ * The class of an OPT record is the UDP payload size of the sender and its TTL holds
+ * the extended RCODE, the EDNS version and the DO bit (RFC 6891). The client subnet
+ * option (code 8, RFC 7871) carries only the bytes covered by the source prefix.
+ *
+ * @param section text of the record is appended here, nullptr only fills info
+ */
+void parseOpt(const u_char *rdata, uint16_t rdlength, uint16_t payload_size, uint32_t ttl, std::string *section, dnsMessageInfo &info)
+{
+    // sizes below 512 are treated as 512
+    info.edns_size = payload_size < 512 ? 512 : payload_size;
+    info.edns_do = (ttl & 0x8000) != 0;
+    if (section != nullptr)
+    {
+        *section += "OPT UDP=" + std::to_string(payload_size) + ", Version=" + std::to_string((ttl >> 16) & 0xff) + ", DO=" + std::to_string(info.edns_do ? 1 : 0);
+    }
+
+    for (uint16_t position = 0; position + 4 <= rdlength;)
+    {
+        uint16_t code = (rdata[position] << 8) | rdata[position + 1];
+        uint16_t length = (rdata[position + 2] << 8) | rdata[position + 3];
+        const u_char *option = rdata + position + 4;
+        position += 4 + length;
+        if (position > rdlength)
+        {
+            break;
+        }
+        if (code != 8 || length < 4)
+        {
+            continue;
+        }
+
+        uint16_t family = (option[0] << 8) | option[1];
+        uint8_t source = option[2];
+        uint8_t scope = option[3];
+        int address_length = family == 1 ? 4 : family == 2 ? 16 : 0;
+        if (address_length == 0 || source > address_length * 8 || length - 4 != (source + 7) / 8)
+        {
+            continue;
+        }
+
+        info.ecs_family = family == 1 ? AF_INET : AF_INET6;
+        info.ecs_prefix = source;
+        std::memset(info.ecs_address, 0, sizeof(info.ecs_address));
+        std::memcpy(info.ecs_address, option + 4, length - 4);
+        if (anonymizerActive())
+        {
+            anonymizeAddress(info.ecs_family, info.ecs_address);
+        }
+        // the bits past the prefix must be zero, a pseudonym fills them
+        for (int bit = source; bit < address_length * 8; bit++)
+        {
+            info.ecs_address[bit / 8] &= (uint8_t)~(0x80 >> (bit % 8));
+        }
+
+        if (section != nullptr)
+        {
+            char address[IP_TEXT_LENGTH];
+            size_t text = info.ecs_family == AF_INET ? formatIPv4(address, info.ecs_address) : formatIPv6(address, info.ecs_address);
+            *section += ", ECS=" + std::string(address, text) + "/" + std::to_string(source) + "/" + std::to_string(scope);
+        }
+    }
+    if (section != nullptr)
+    {
+        *section += "\n";
+    }
+}
+
+void parseSection(const u_char *packet, int &offset, int record_count, userArgs *args, int dns_header_offset, std::string &section, nameGraph &graph, dnsMessageInfo &info)
 {
     for (int i = 0; i < record_count; i++)
     {
@@ -183,6 +460,14 @@ void parseSection(const u_char *packet, int &offset, int record_count, userArgs
 
         std::string result;
 
+        // the class of an OPT record is not IN but the payload size
+        if (answer_type == 41)
+        {
+            parseOpt(packet + offset, answer_rdlength, answer_class, answer_ttl, &section, info);
+            offset += answer_rdlength;
+            continue;
+        }
+
         if (answer_class != 1)
         {
             offset += answer_rdlength; // Move to the next answer
@@ -201,9 +486,6 @@ void parseSection(const u_char *packet, int &offset, int record_count, userArgs
         uint16_t priority;
         
 
-        //print size of srv
-        std::cout << "velkost srv: " << sizeof(dnsSRV) << std::endl;
-
         switch (answer_type)
         {
         case 1: // A
@@ -212,6 +494,7 @@ void parseSection(const u_char *packet, int &offset, int record_count, userArgs
                 is_ip = true;
                 const uint8_t *ip = packet + offset;
                 result = inet_ntoa(*(struct in_addr *)ip);
+                addChainAddress(graph, global_arena, domain_name, result);
                 section += domain_name + " " + std::to_string(answer_ttl) + " " + class_str + " " + type_str + " " + result + "\n";
                 offset += answer_rdlength;
             }
@@ -224,6 +507,7 @@ void parseSection(const u_char *packet, int &offset, int record_count, userArgs
                 char ipv6_str[INET6_ADDRSTRLEN];
                 inet_ntop(AF_INET6, ipv6, ipv6_str, INET6_ADDRSTRLEN);
                 result = ipv6_str;
+                addChainAddress(graph, global_arena, domain_name, result);
                 section += domain_name + " " + std::to_string(answer_ttl) + " " + class_str + " " + type_str + " " + result + "\n";
                 offset += answer_rdlength;
             }
@@ -236,6 +520,7 @@ void parseSection(const u_char *packet, int &offset, int record_count, userArgs
         case 5: // CNAME
             extractDomainName(packet, offset, result, dns_header_offset);
             offset += calculateDomainLength(packet, offset, dns_header_offset);
+            addChainEdge(graph, global_arena, domain_name, result);
             section += domain_name + " " + std::to_string(answer_ttl) + " " + class_str + " " + type_str + " " + result + "\n";
             break;
         case 6: // SOA
@@ -289,108 +574,119 @@ void parseSection(const u_char *packet, int &offset, int record_count, userArgs
     }
 }
 
-void verboseOutput(char *buffer, const ip *ip_header, udphdr *udp_header, dnsHeader *dns_header, std::string &question_section, std::string &answer_section, std::string &authority_section, std::string &additional_section)
+// writes the source or destination address of an IPv4 or IPv6 header, pseudonymized when enabled
+size_t formatAddress(char *out, const ip *ip_header, bool source)
 {
-    struct in_addr src_ip = ip_header->ip_src;
-    struct in_addr dst_ip = ip_header->ip_dst;
-    std::cout << "Timestamp: " << buffer << std::endl;
-    std::cout << "SrcIP: " << inet_ntoa(src_ip) << std::endl;
-    std::cout << "DstIP: " << inet_ntoa(dst_ip) << std::endl;
-    std::cout << "SrcPort: UDP/" << ntohs(udp_header->uh_sport) << std::endl;
-    std::cout << "DstPort: UDP/" << ntohs(udp_header->uh_dport) << std::endl;
-    std::cout << "Identifier: " << std::hex << ntohs(dns_header->id) << std::dec << std::endl;
-    uint16_t flags = ntohs(dns_header->flags);
-    std::cout << "Flags:"
-              << " QR=" << ((flags & 0x8000) >> 15)
-              << ", Opcode=" << ((flags & 0x7800) >> 11)
-              << ", AA=" << ((flags & 0x0400) >> 10)
-              << ", TC=" << ((flags & 0x0200) >> 9)
-              << ", RD=" << ((flags & 0x0100) >> 8)
-              << ", RA=" << ((flags & 0x0080) >> 7)
-              << ", AD=" << ((flags & 0x0020) >> 5)
-              << ", CD=" << ((flags & 0x0010) >> 4)
-              << ", RCODE=" << (flags & 0x000F) << std::endl;
-    std::cout << std::endl;
-    if (!question_section.empty())
+    uint8_t address[16];
+    if (ip_header->ip_v == 6)
     {
-        std::cout << "[Question Section]" << std::endl;
-        std::cout << question_section << std::endl;
-    }
-    if (!answer_section.empty())
-    {
-        std::cout << "[Answer Section]" << std::endl;
-        std::cout << answer_section << std::endl;
-    }
-    if (!authority_section.empty())
-    {
-        std::cout << "[Authority Section]" << std::endl;
-        std::cout << authority_section << std::endl;
+        const struct ip6_hdr *ip6_header = (const struct ip6_hdr *)ip_header;
+        std::memcpy(address, source ? &ip6_header->ip6_src : &ip6_header->ip6_dst, 16);
+        if (anonymizerActive())
+        {
+            anonymizeAddress(AF_INET6, address);
+        }
+        return formatIPv6(out, address);
     }
-    if (!additional_section.empty())
+    std::memcpy(address, source ? &ip_header->ip_src : &ip_header->ip_dst, 4);
+    if (anonymizerActive())
     {
-        std::cout << "[Additional Section]" << std::endl;
-        std::cout << additional_section << std::endl;
+        anonymizeAddress(AF_INET, address);
     }
-    std::cout << "====================" << std::endl;
+    return formatIPv4(out, address);
 }
 
-void nonVerboseOutput(char *buffer, ip *ip_header, dnsHeader *dns_header)
+void appendSection(const char *title, const std::string &section)
 {
-    std::string src_ip_str;
-    std::string dst_ip_str;
-
-    if (ip_header->ip_v == 4) // IPv4
-    {
-        struct in_addr src_ip = ip_header->ip_src;
-        struct in_addr dst_ip = ip_header->ip_dst;
-        src_ip_str = inet_ntoa(src_ip);
-        dst_ip_str = inet_ntoa(dst_ip);
-    }
-    else if (ip_header->ip_v == 6) // IPv6
+    if (!section.empty())
     {
-        struct ip6_hdr *ip6_header = (struct ip6_hdr *)ip_header;
-        char src_ip[INET6_ADDRSTRLEN];
-        char dst_ip[INET6_ADDRSTRLEN];
-        inet_ntop(AF_INET6, &ip6_header->ip6_src, src_ip, INET6_ADDRSTRLEN);
-        inet_ntop(AF_INET6, &ip6_header->ip6_dst, dst_ip, INET6_ADDRSTRLEN);
-        src_ip_str = src_ip;
-        dst_ip_str = dst_ip;
+        appendOutput(standard_output, title);
+        appendOutput(standard_output, section.data(), section.size());
+        appendOutput(standard_output, "\n", 1);
     }
+}
 
-    std::string query_response;
+void verboseOutput(const struct timeval &ts, const ip *ip_header, udphdr *udp_header, dnsHeader *dns_header, std::string &question_section, std::string &answer_section, std::string &authority_section, std::string &additional_section)
+{
+    char *out = reserveOutput(standard_output, 64 + 2 * IP_TEXT_LENGTH);
+    size_t length = 0;
+
+    std::memcpy(out + length, "Timestamp: ", 11);
+    length += 11;
+    length += formatTimestamp(out + length, ts);
+    std::memcpy(out + length, "\nSrcIP: ", 8);
+    length += 8;
+    length += formatAddress(out + length, ip_header, true);
+    std::memcpy(out + length, "\nDstIP: ", 8);
+    length += 8;
+    length += formatAddress(out + length, ip_header, false);
+    out[length++] = '\n';
+    commitOutput(standard_output, length);
+
+    appendOutput(standard_output, "SrcPort: UDP/");
+    appendUnsigned(standard_output, ntohs(udp_header->uh_sport));
+    appendOutput(standard_output, "\nDstPort: UDP/");
+    appendUnsigned(standard_output, ntohs(udp_header->uh_dport));
+    appendOutput(standard_output, "\nIdentifier: ");
+    commitOutput(standard_output, formatHex(reserveOutput(standard_output, 8), ntohs(dns_header->id)));
 
-    // check for query
-    //  After populating the dns_header
-    if (dns_header->flags & htons(0x8000))
-    {
-        query_response = "R";
-    }
-    else
+    uint16_t flags = ntohs(dns_header->flags);
+    const char *names[] = {"\nFlags: QR=", ", Opcode=", ", AA=", ", TC=", ", RD=", ", RA=", ", AD=", ", CD=", ", RCODE="};
+    unsigned values[] = {(flags & 0x8000u) >> 15, (flags & 0x7800u) >> 11, (flags & 0x0400u) >> 10,
+                         (flags & 0x0200u) >> 9, (flags & 0x0100u) >> 8, (flags & 0x0080u) >> 7,
+                         (flags & 0x0020u) >> 5, (flags & 0x0010u) >> 4, flags & 0x000Fu};
+    for (int i = 0; i < 9; i++)
     {
-        query_response = "Q";
+        appendOutput(standard_output, names[i]);
+        appendUnsigned(standard_output, values[i]);
     }
+    appendOutput(standard_output, "\n\n", 2);
 
-    std::cout << buffer << " " << src_ip_str << " -> " << dst_ip_str << " (" << query_response << " " << ntohs(dns_header->question_count) << "/" << ntohs(dns_header->answer_count) << "/" << ntohs(dns_header->authority_count) << "/" << ntohs(dns_header->arcount) << ")" << std::endl;
+    appendSection("[Question Section]\n", question_section);
+    appendSection("[Answer Section]\n", answer_section);
+    appendSection("[Authority Section]\n", authority_section);
+    appendSection("[Additional Section]\n", additional_section);
+    appendOutput(standard_output, "====================\n");
 }
-pcap_t *openInteface(const std::string &interface)
+
+void nonVerboseOutput(const struct timeval &ts, ip *ip_header, dnsHeader *dns_header, bool watchlisted)
 {
-    char errbuf[PCAP_ERRBUF_SIZE];
-    pcap_t *handle = pcap_open_live(interface.c_str(), BUFSIZ, 1, 1000, errbuf);
-    if (handle == nullptr)
+    // timestamp, two addresses, four counts and the markers always fit
+    char *out = reserveOutput(standard_output, 128 + 2 * IP_TEXT_LENGTH);
+    size_t length = formatTimestamp(out, ts);
+
+    out[length++] = ' ';
+    length += formatAddress(out + length, ip_header, true);
+    std::memcpy(out + length, " -> ", 4);
+    length += 4;
+    length += formatAddress(out + length, ip_header, false);
+
+    out[length++] = ' ';
+    out[length++] = '(';
+    // check for query
+    out[length++] = (dns_header->flags & htons(0x8000)) ? 'R' : 'Q';
+    out[length++] = ' ';
+    length += formatUnsigned(out + length, ntohs(dns_header->question_count));
+    out[length++] = '/';
+    length += formatUnsigned(out + length, ntohs(dns_header->answer_count));
+    out[length++] = '/';
+    length += formatUnsigned(out + length, ntohs(dns_header->authority_count));
+    out[length++] = '/';
+    length += formatUnsigned(out + length, ntohs(dns_header->arcount));
+    out[length++] = ')';
+
+    if (watchlisted)
     {
-        std::cerr << "Could not open interface " << interface << ": " << errbuf << std::endl;
-        return nullptr;
+        std::memcpy(out + length, " [watchlist]", 12);
+        length += 12;
     }
-
-    std::cout << "Interface " << interface << " opened" << std::endl;
-
-    return handle;
+    out[length++] = '\n';
+    commitOutput(standard_output, length);
 }
 
-void packetHandler(u_char *userData, const struct pcap_pkthdr *pkthdr, const u_char *packet)
+// decodes the L3/L4 headers, false when the packet is not a DNS message over UDP
+bool decodePacket(const struct pcap_pkthdr *pkthdr, const u_char *packet, decodedPacket &decoded, dnsMessageInfo &info)
 {
-    userArgs *args = (userArgs *)userData;
-
     struct ip *ip_header = (struct ip *)(packet + ETHERNET_HEADER_SIZE);
 
     int ip_header_len = 0;
@@ -416,18 +712,15 @@ void packetHandler(u_char *userData, const struct pcap_pkthdr *pkthdr, const u_c
     // program captures only UDP packets
     if (int(protocol) != IPPROTO_UDP)
     {
-        return;
+        return false;
     }
 
-    char timestamp[64];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&pkthdr->ts.tv_sec));
-
     struct udphdr *udp_header = (struct udphdr *)(packet + ETHERNET_HEADER_SIZE + ip_header_len);
 
     // program captures only DNS packets
     if (ntohs(udp_header->uh_dport) != 53 && ntohs(udp_header->uh_sport) != 53)
     {
-        return;
+        return false;
     }
 
     // dns header offset depends on the length of the ip header
@@ -436,47 +729,358 @@ void packetHandler(u_char *userData, const struct pcap_pkthdr *pkthdr, const u_c
     // get the dns header
     dnsHeader *dns_header = (dnsHeader *)(packet + dns_header_offset);
 
-    int offset = ETHERNET_HEADER_SIZE + ip_header_len + UDP_HEADER_SIZE + sizeof(dnsHeader);
+    decoded.pkthdr = pkthdr;
+    decoded.packet = packet;
+    decoded.ip_header = ip_header;
+    decoded.udp_header = udp_header;
+    decoded.dns_header = dns_header;
+    decoded.dns_header_offset = dns_header_offset;
+
+    info.ts = pkthdr->ts;
+    info.flags = ntohs(dns_header->flags);
+    info.response = (info.flags & 0x8000) != 0;
+    info.size = ntohs(udp_header->uh_ulen) - UDP_HEADER_SIZE;
+    info.qtype = 0;
+    info.qname_hash = 0;
+    info.edns_size = 0;
+    info.edns_do = false;
+    info.ecs_family = 0;
+    // the client is the sender of a query and the receiver of a response
+    if (ip_header->ip_v == 4)
+    {
+        info.family = AF_INET;
+        std::memcpy(info.client, info.response ? &ip_header->ip_dst : &ip_header->ip_src, 4);
+    }
+    else
+    {
+        const struct ip6_hdr *ip6_header = (struct ip6_hdr *)ip_header;
+        info.family = AF_INET6;
+        std::memcpy(info.client, info.response ? &ip6_header->ip6_dst : &ip6_header->ip6_src, 16);
+    }
+    // statistics and alerts name clients, they see the pseudonym as well
+    if (anonymizerActive())
+    {
+        anonymizeAddress(info.family, info.client);
+    }
+    return true;
+}
+
+// hash of the addresses and the whole UDP datagram, the DNS id and ports included
+uint64_t messageKey(const decodedPacket &decoded)
+{
+    uint64_t key;
+    if (decoded.ip_header->ip_v == 4)
+    {
+        key = dedupHash(&decoded.ip_header->ip_src, 8, decoded.ip_header->ip_v);
+    }
+    else
+    {
+        key = dedupHash(&((const struct ip6_hdr *)decoded.ip_header)->ip6_src, 32, decoded.ip_header->ip_v);
+    }
+
+    // the datagram length comes from the header, a truncated capture hashes what it has
+    size_t udp_offset = decoded.dns_header_offset - UDP_HEADER_SIZE;
+    if (decoded.pkthdr->caplen <= udp_offset)
+    {
+        return key;
+    }
+    size_t length = ntohs(decoded.udp_header->uh_ulen);
+    size_t captured = decoded.pkthdr->caplen - udp_offset;
+    return dedupHash(decoded.udp_header, length < captured ? length : captured, key);
+}
+
+// fills the header fields of the published record, the question was added by parseQuestion
+void fillRecord(dnsRingRecord &record, const decodedPacket &decoded, const dnsMessageInfo &info, bool watchlisted)
+{
+    record.ts_sec = decoded.pkthdr->ts.tv_sec;
+    record.ts_usec = decoded.pkthdr->ts.tv_usec;
+    record.family = info.family;
+    record.watchlisted = watchlisted;
+    record.src_port = ntohs(decoded.udp_header->uh_sport);
+    record.dst_port = ntohs(decoded.udp_header->uh_dport);
+    record.id = ntohs(decoded.dns_header->id);
+    record.flags = info.flags;
+    record.qtype = info.qtype;
+    record.counts[0] = ntohs(decoded.dns_header->question_count);
+    record.counts[1] = ntohs(decoded.dns_header->answer_count);
+    record.counts[2] = ntohs(decoded.dns_header->authority_count);
+    record.counts[3] = ntohs(decoded.dns_header->arcount);
+    record.size = info.size;
+
+    std::memset(record.src, 0, sizeof(record.src));
+    std::memset(record.dst, 0, sizeof(record.dst));
+    if (info.family == AF_INET)
+    {
+        std::memcpy(record.src, &decoded.ip_header->ip_src, 4);
+        std::memcpy(record.dst, &decoded.ip_header->ip_dst, 4);
+    }
+    else
+    {
+        const struct ip6_hdr *ip6_header = (const struct ip6_hdr *)decoded.ip_header;
+        std::memcpy(record.src, &ip6_header->ip6_src, 16);
+        std::memcpy(record.dst, &ip6_header->ip6_dst, 16);
+    }
+    if (anonymizerActive())
+    {
+        anonymizeAddress(info.family, record.src);
+        anonymizeAddress(info.family, record.dst);
+    }
+}
+
+// parses the sections of a decoded message and writes its output, verbose is off while shedding
+void processPacket(const decodedPacket &decoded, dnsMessageInfo &info, userArgs *args, bool verbose)
+{
+    TRACE_BEGIN();
+
+    const u_char *packet = decoded.packet;
+    dnsHeader *dns_header = decoded.dns_header;
+    int dns_header_offset = decoded.dns_header_offset;
+    int offset = dns_header_offset + sizeof(dnsHeader);
 
     std::string question_section;
     std::string answer_section;
     std::string authority_section;
     std::string additional_section;
+    int watchlist_matches = 0;
+
+    // names collected for CNAME resolution live in the arena until the next packet
+    global_arena.used = 0;
+    global_graph.edge_count = 0;
+    global_graph.address_count = 0;
+
+    if (publisherActive())
+    {
+        publish_record = beginRecord();
+        publish_record->qname[0] = '\0';
+        publish_record->qname_length = 0;
+        publish_record->qclass = 0;
+    }
 
     // parse the question
     if (ntohs(dns_header->question_count) > 0)
     {
-        parseQuestion(packet, offset, ntohs(dns_header->question_count), args, dns_header_offset, question_section);
+        watchlist_matches = parseQuestion(packet, offset, ntohs(dns_header->question_count), args, dns_header_offset, question_section, info);
     }
+    TRACE_STAGE(TRACE_QUESTION, question);
 
     // if packet is a response, parse the answer
     if (dns_header->answer_count > 0)
     {
-        parseSection(packet, offset, ntohs(dns_header->answer_count), args, dns_header_offset, answer_section);
+        parseSection(packet, offset, ntohs(dns_header->answer_count), args, dns_header_offset, answer_section, global_graph, info);
     }
 
     // if packet has authority, parse the authority
     if (dns_header->authority_count > 0)
     {
-        parseSection(packet, offset, ntohs(dns_header->authority_count), args, dns_header_offset, authority_section);
+        parseSection(packet, offset, ntohs(dns_header->authority_count), args, dns_header_offset, authority_section, global_graph, info);
     }
 
     // if packet has additional, parse the additional
     if (dns_header->arcount > 0)
     {
-        parseSection(packet, offset, ntohs(dns_header->arcount), args, dns_header_offset, additional_section);
+        parseSection(packet, offset, ntohs(dns_header->arcount), args, dns_header_offset, additional_section, global_graph, info);
     }
 
+    resolveChains(global_graph, args);
+    TRACE_STAGE(TRACE_SECTIONS, sections);
+
     // print depending on the verbose flag
-    if (args->verbose)
+    if (verbose)
     {
-        verboseOutput(timestamp, ip_header, udp_header, dns_header, question_section, answer_section, authority_section, additional_section);
+        verboseOutput(decoded.pkthdr->ts, decoded.ip_header, decoded.udp_header, dns_header, question_section, answer_section, authority_section, additional_section);
     }
     else
     {
-        nonVerboseOutput(timestamp, ip_header, dns_header);
+        nonVerboseOutput(decoded.pkthdr->ts, decoded.ip_header, dns_header, watchlist_matches > 0);
+    }
+    if (publish_record != nullptr)
+    {
+        fillRecord(*publish_record, decoded, info, watchlist_matches > 0);
+        commitRecord();
+        publish_record = nullptr;
     }
+    TRACE_STAGE(TRACE_OUTPUT, output);
 }
+
+/**
+ * @brief Decodes what the statistics and the detector need from a message without rendering it
+ *
+ * The question names are only matched against the watchlist and the first one is noted,
+ * the answer and authority records are skipped and the additional section is searched
+ * for the OPT record. Used while sections are shed.
+ *
+ * @return number of question names that matched the watchlist
+ */
+int scanMessage(const decodedPacket &decoded, dnsMessageInfo &info)
+{
+    const u_char *packet = decoded.packet;
+    const dnsHeader *dns_header = decoded.dns_header;
+    int dns_header_offset = decoded.dns_header_offset;
+    int offset = dns_header_offset + sizeof(dnsHeader);
+    int captured = decoded.pkthdr->caplen;
+    const watchlistTable *watchlist = activeWatchlist();
+    int watchlist_matches = 0;
+
+    int question_count = ntohs(dns_header->question_count);
+    for (int i = 0; i < question_count && offset < captured; i++)
+    {
+        std::string domain_name;
+        extractDomainName(packet, offset, domain_name, dns_header_offset);
+        offset += calculateDomainLength(packet, offset, dns_header_offset);
+
+        dnsQuestion question;
+        std::memcpy(&question, packet + offset, sizeof(dnsQuestion));
+        offset += sizeof(dnsQuestion);
+
+        if (i == 0)
+        {
+            noteFirstQuestion(domain_name, question, info);
+        }
+        if (watchlist != nullptr && matchWatchlist(watchlist, domain_name.data(), domain_name.size()))
+        {
+            watchlist_matches++;
+        }
+    }
+    global_counters.watchlist_matches += watchlist_matches;
+
+    // the OPT record is in the additional section, the records before it are only skipped
+    int skipped = ntohs(dns_header->answer_count) + ntohs(dns_header->authority_count);
+    int record_count = skipped + ntohs(dns_header->arcount);
+    for (int i = 0; i < record_count && offset < captured; i++)
+    {
+        offset += calculateDomainLength(packet, offset, dns_header_offset);
+        if (offset + (int)sizeof(dnsAnswer) > captured)
+        {
+            break;
+        }
+        dnsAnswer answer;
+        std::memcpy(&answer, packet + offset, sizeof(dnsAnswer));
+        offset += sizeof(dnsAnswer);
+
+        uint16_t rdlength = ntohs(answer.rdlength);
+        if (i >= skipped && ntohs(answer.type) == 41 && offset + rdlength <= captured)
+        {
+            parseOpt(packet + offset, rdlength, ntohs(answer.answer_class), ntohl(answer.ttl), nullptr, info);
+        }
+        offset += rdlength;
+    }
+    return watchlist_matches;
+}
+
+/**
+ * @brief Handles a message while sections are shed, the one-line form is built from the DNS header
+ *
+ * @param print false for the messages sampled out, they are only decoded
+ */
+void processHeaders(const decodedPacket &decoded, dnsMessageInfo &info, bool print)
+{
+    if (print && publisherActive())
+    {
+        publish_record = beginRecord();
+        publish_record->qname[0] = '\0';
+        publish_record->qname_length = 0;
+        publish_record->qclass = 0;
+    }
+
+    int watchlist_matches = scanMessage(decoded, info);
+
+    if (print)
+    {
+        nonVerboseOutput(decoded.pkthdr->ts, decoded.ip_header, decoded.dns_header, watchlist_matches > 0);
+    }
+    if (publish_record != nullptr)
+    {
+        fillRecord(*publish_record, decoded, info, watchlist_matches > 0);
+        commitRecord();
+        publish_record = nullptr;
+    }
+}
+
+/**
+ * @brief Processes a batch of captured packets phase by phase
+ *
+ * The headers of all packets are decoded first, with the packets a few positions ahead
+ * prefetched, then the DNS messages are parsed and printed in capture order and the
+ * aggregates are updated once for the whole batch.
+ */
+void processBatch(const packetBatch &batch, u_char *userData)
+{
+    userArgs *args = (userArgs *)userData;
+    static decodedPacket decoded[PACKET_BATCH];
+    static dnsMessageInfo infos[PACKET_BATCH];
+    size_t count = 0;
+
+    for (size_t i = 0; i < BATCH_PREFETCH && i < batch.count; i++)
+    {
+        __builtin_prefetch(batch.packets[i] + ETHERNET_HEADER_SIZE);
+    }
+
+    TRACE_BEGIN();
+    for (size_t i = 0; i < batch.count; i++)
+    {
+        if (i + BATCH_PREFETCH < batch.count)
+        {
+            __builtin_prefetch(batch.packets[i + BATCH_PREFETCH] + ETHERNET_HEADER_SIZE);
+        }
+        if (!decodePacket(&batch.headers[i], batch.packets[i], decoded[count], infos[count]))
+        {
+            continue;
+        }
+        // retransmissions and mirrored copies are dropped before the sections are parsed
+        if (dedupActive() && isDuplicate(messageKey(decoded[count]), batch.headers[i].ts))
+        {
+            global_counters.duplicates++;
+            continue;
+        }
+        count++;
+    }
+    TRACE_BATCH_STAGE(TRACE_DECODE, decode, batch.count);
+
+    SHED_LEVEL level = SHED_NONE;
+    if (sheddingActive())
+    {
+        if (live_lag && batch.count > 0)
+        {
+            struct timespec now;
+            clock_gettime(CLOCK_REALTIME, &now);
+            const struct timeval &ts = batch.headers[batch.count - 1].ts;
+            reportLag(((int64_t)now.tv_sec - ts.tv_sec) * 1000000000 + now.tv_nsec - (int64_t)ts.tv_usec * 1000);
+        }
+        level = updateShedLevel();
+    }
+
+    beginWatchlistUse();
+    for (size_t i = 0; i < count; i++)
+    {
+        // the question name usually continues past the cache line holding the headers
+        if (i + 1 < count)
+        {
+            __builtin_prefetch((const u_char *)decoded[i + 1].dns_header + 64);
+        }
+        // shed messages are still decoded far enough for the aggregates and the detector below
+        if (level >= SHED_SECTIONS)
+        {
+            bool print = level < SHED_SAMPLE || sampleMessage();
+            countShed(print ? SHED_SECTIONS : SHED_SAMPLE);
+            processHeaders(decoded[i], infos[i], print);
+        }
+        else
+        {
+            if (level == SHED_VERBOSE && args->verbose)
+            {
+                countShed(SHED_VERBOSE);
+            }
+            processPacket(decoded[i], infos[i], args, args->verbose && level == SHED_NONE);
+        }
+    }
+    endWatchlistUse();
+
+    TRACE_RESTART();
+    recordMessages(infos, count);
+    observeMessages(infos, count);
+    TRACE_BATCH_STAGE(TRACE_AGGREGATE, aggregate, count);
+}
+
 /**
  * @brief Closes the interface
  *
@@ -487,16 +1091,76 @@ void closeInterface(pcap_t *handle)
     pcap_close(handle);
 }
 
-// ctrl+c
+/**
+ * @brief Writes the rest of the compressed outputs and stops the compression workers
+ *
+ * Also joins workers whose sinks could not be opened, nothing happens when none were started.
+ */
+void closeCompressedOutputs()
+{
+    closeSink(standard_output.sink);
+    standard_output.sink = nullptr;
+    closeSink(domains_sink);
+    domains_sink = nullptr;
+    closeSink(translations_sink);
+    translations_sink = nullptr;
+    stopCompression();
+}
+
+/**
+ * @brief Prints the counters collected during the run to stderr
+ */
+void printStatistics()
+{
+    if (activeWatchlist() != nullptr)
+    {
+        std::cerr << "Watchlist matches: " << global_counters.watchlist_matches << std::endl;
+    }
+    if (dedupActive())
+    {
+        std::cerr << "Duplicates dropped: " << global_counters.duplicates << std::endl;
+    }
+    if (detectorActive())
+    {
+        std::cerr << "Detector alerts: " << detectorAlerts() << std::endl;
+    }
+    if (publishedRecords() > 0)
+    {
+        std::cerr << "Records published: " << publishedRecords() << std::endl;
+    }
+    printSheddingReport();
+    printReplayReport();
+#ifdef DNS_MONITOR_TRACE
+    printTraceReport();
+#endif
+}
+
+// ctrl+c, only flags are set here, the capture loop returns and main shuts down through finishRun
+
+volatile sig_atomic_t interrupt_signal = 0;
 
 void signalHandler(int signum)
 {
-    // Close the pcap handle
+    interrupt_signal = signum;
+    stopCapture();
+    // pcap_loop over a pcap file only returns early on a breakloop
     if (global_handle != nullptr)
     {
-        pcap_close(global_handle);
-        global_handle = nullptr;
+        pcap_breakloop(global_handle);
     }
+}
+
+/**
+ * @brief Flushes and closes everything main opened, every exit after the first resource goes through here
+ *
+ * @param statistics print the counters of the run, off for errors during startup
+ * @return exit code for main, the signal number when the run was interrupted
+ */
+int finishRun(int result, bool statistics)
+{
+    flushBatch();
+    flushOutput(standard_output);
+    closeCompressedOutputs();
 
     // Close the files
     if (global_args.domains_file.is_open())
@@ -508,40 +1172,208 @@ void signalHandler(int signum)
         global_args.translations_file.close();
     }
 
-    exit(signum);
+    if (global_handle != nullptr)
+    {
+        closeInterface(global_handle);
+        global_handle = nullptr;
+    }
+    closeInterfaces(global_interfaces);
+    closeAggregates();
+    closeDomainStore();
+    closePublisher();
+    if (statistics)
+    {
+        printStatistics();
+    }
+    closeDetector();
+    return interrupt_signal != 0 ? interrupt_signal : result;
 }
 
 int main(int argc, char *argv[])
 {
+    if (!parseMonitorOptions(argc, argv, global_options))
+    {
+        return 1;
+    }
     parseArguments(argc, argv, global_args);
 
     signal(SIGINT, signalHandler);
 
+    int sources = !global_args.interface.empty() + !global_args.pcapfile.empty() + !global_options.xdp_interface.empty();
+
     // if no interface or pcap file specified
-    if (global_args.interface.empty() && global_args.pcapfile.empty())
+    if (sources == 0)
     {
         std::cerr << "No interface or pcap file specified" << std::endl;
         return 1;
     }
 
     // if both interface and pcap file specified
-    if (!global_args.interface.empty() && !global_args.pcapfile.empty())
+    if (sources > 1)
     {
-        std::cerr << "Both interface and pcap file specified" << std::endl;
+        std::cerr << "Only one of -i, -p and --xdp can be specified" << std::endl;
         return 1;
     }
 
-    // if interface specified
-    if (!global_args.interface.empty())
+    // without a queue no socket is created and the capture would only wait for SIGINT
+    if (!global_options.xdp_interface.empty() && global_options.xdp_queues == 0)
     {
-        global_handle = openInteface(global_args.interface);
-        if (global_handle == nullptr)
+        std::cerr << "--xdp-queues must be at least 1" << std::endl;
+        return 1;
+    }
+
+    // --build-index only writes the index of the pcap file
+    if (global_options.index_interval != 0)
+    {
+        if (global_args.pcapfile.empty())
         {
+            std::cerr << "--build-index needs a pcap file (-p)" << std::endl;
             return 1;
         }
-        pcap_loop(global_handle, 0, packetHandler, (u_char *)&global_args);
-        closeInterface(global_handle);
-        return 0;
+        return buildPcapIndex(global_args.pcapfile, global_options.index_interval) ? 0 : 1;
+    }
+
+    // time range of the offline analysis, the whole file by default
+    bool time_range = !global_options.range_from.empty() || !global_options.range_to.empty();
+    int64_t range_from = INT64_MIN + PCAP_INDEX_SLACK_USEC;
+    int64_t range_to = INT64_MAX - PCAP_INDEX_SLACK_USEC;
+    if (time_range && global_args.pcapfile.empty())
+    {
+        std::cerr << "--from and --to can only be used with a pcap file (-p)" << std::endl;
+        return 1;
+    }
+    if ((!global_options.range_from.empty() && !parseTime(global_options.range_from, range_from)) ||
+        (!global_options.range_to.empty() && !parseTime(global_options.range_to, range_to)))
+    {
+        std::cerr << "Invalid time, expected \"YYYY-MM-DD HH:MM:SS[.uuuuuu]\" or seconds since the epoch" << std::endl;
+        return 1;
+    }
+
+    bool checkpoints = !global_options.checkpoint_file.empty();
+    if (checkpoints && (global_args.pcapfile.empty() || time_range || global_options.checkpoint_interval == 0))
+    {
+        std::cerr << "--checkpoint needs a pcap file (-p), a nonzero interval and cannot be combined with --from/--to" << std::endl;
+        return 1;
+    }
+
+    double replay_speed = 0;
+    bool replay = !global_options.replay_speed.empty();
+    if (replay && (global_args.pcapfile.empty() || time_range || checkpoints || !parseReplaySpeed(global_options.replay_speed, replay_speed)))
+    {
+        std::cerr << "--replay needs a pcap file (-p) and a speed (max or a multiplier), it cannot be combined with --from/--to or --checkpoint" << std::endl;
+        return 1;
+    }
+
+    // an offline file has no deadline, only a live capture or a paced replay can fall behind
+    if (global_options.shed_lag != 0)
+    {
+        live_lag = !global_args.interface.empty() || !global_options.xdp_interface.empty();
+        if (!live_lag && !(replay && replay_speed > 0))
+        {
+            std::cerr << "--shed needs a live capture (-i, --xdp) or a --replay with a speed" << std::endl;
+            return 1;
+        }
+        initShedding(global_options.shed_lag);
+    }
+
+    // the checkpoint restores in-memory sets, the store would already contain newer entries
+    if (checkpoints && !global_options.store_file.empty())
+    {
+        std::cerr << "--checkpoint cannot be combined with --store" << std::endl;
+        return 1;
+    }
+
+    if (global_options.dedup_window != 0)
+    {
+        initDedup(global_options.dedup_window);
+    }
+
+    if (!global_options.anonymize_key.empty() && !initAnonymizer(global_options.anonymize_key))
+    {
+        return 1;
+    }
+
+    bool compressed_domains = !global_options.domains_gz_file.empty() || !global_options.translations_gz_file.empty();
+    if (compressed_domains && checkpoints)
+    {
+        std::cerr << "--checkpoint cannot be combined with --domains-gz or --translations-gz" << std::endl;
+        return 1;
+    }
+
+    if (!global_options.publish_name.empty() && !initPublisher(global_options.publish_name, global_options.publish_slots))
+    {
+        return 1;
+    }
+
+    // threads are pinned before any of them is started and before the packet buffers are first touched
+    if (!global_options.capture_cpus.empty() || !global_options.worker_cpus.empty())
+    {
+        const std::string &interfaces = global_options.xdp_interface.empty() ? global_args.interface : global_options.xdp_interface;
+        if (!initAffinity(global_options.capture_cpus, global_options.worker_cpus, interfaces))
+        {
+            return finishRun(1, false);
+        }
+    }
+
+    // the watchlist blocks SIGHUP for its reload thread, so it comes before any other thread is started
+    if (!global_options.watchlist_file.empty() && !initWatchlist(global_options.watchlist_file))
+    {
+        return finishRun(1, false);
+    }
+
+    // compression workers are worker threads, so they are started after the CPUs are assigned
+    if (compressed_domains || !global_options.output_file.empty())
+    {
+        uint64_t rotate_bytes = (uint64_t)global_options.rotate_size << 20;
+        if (!startCompression(global_options.compress_threads))
+        {
+            std::cerr << "--compress-threads must be at least 1" << std::endl;
+            return finishRun(1, false);
+        }
+        if ((!global_options.output_file.empty() && (standard_output.sink = openSink(global_options.output_file, rotate_bytes)) == nullptr) ||
+            (!global_options.domains_gz_file.empty() && (domains_sink = openSink(global_options.domains_gz_file, rotate_bytes)) == nullptr) ||
+            (!global_options.translations_gz_file.empty() && (translations_sink = openSink(global_options.translations_gz_file, rotate_bytes)) == nullptr))
+        {
+            return finishRun(1, false);
+        }
+    }
+
+    if (!global_options.alerts_file.empty() && !initDetector(global_options.alerts_file))
+    {
+        return finishRun(1, false);
+    }
+
+    if (!global_options.store_file.empty() && !openDomainStore(global_options.store_file))
+    {
+        return finishRun(1, false);
+    }
+
+    // a resumed run continues the statistics file of the interrupted one
+    bool resume = checkpoints && checkpointMatches(global_options.checkpoint_file, global_args.pcapfile);
+    if (!global_options.stats_file.empty() && !initAggregates(global_options.stats_file, resume))
+    {
+        return finishRun(1, false);
+    }
+
+    // all backends hand their packets over in batches
+    initBatching(processBatch, (u_char *)&global_args);
+
+    // AF_XDP capture from one interface
+    if (!global_options.xdp_interface.empty())
+    {
+        int result = runXdpCapture(global_options.xdp_interface, global_options.xdp_queues, global_options.xdp_mode);
+        return finishRun(result, true);
+    }
+
+    // if interface specified, -i takes a comma separated list of interfaces
+    if (!global_args.interface.empty())
+    {
+        if (!openInterfaces(global_args.interface, global_interfaces))
+        {
+            return finishRun(1, false);
+        }
+        int result = runCaptureLoop(global_interfaces, batchPacket, nullptr);
+        return finishRun(result, true);
     }
 
     // if pcap file specified
@@ -553,21 +1385,36 @@ int main(int argc, char *argv[])
         if (global_handle == nullptr)
         {
             std::cerr << "Could not open pcap file " << global_args.pcapfile << ": " << errbuf << std::endl;
-            return 1;
+            return finishRun(1, false);
         }
-        // extract dns packets from pcap file
-        pcap_loop(global_handle, 0, packetHandler, (u_char *)&global_args);
-        
-        if (global_args.domains_file.is_open())
+        // extract dns packets from pcap file, with a time range only the part covered by it
+        int result = 0;
+        if (replay)
         {
-            global_args.domains_file.close();
+            result = runReplay(global_handle, replay_speed, global_options.replay_loops, batchPacket, nullptr);
         }
-
-        if (global_args.translations_file.is_open())
+        else if (checkpoints)
         {
-            global_args.translations_file.close();
+            checkpointState state;
+            state.domains = &global_args.domainnamesinfile;
+            state.translations = &global_args.domainToIPs;
+            state.aliases = &alias_translations;
+            state.domains_file = &global_args.domains_file;
+            state.translations_file = &global_args.translations_file;
+            state.counters = &global_counters;
+            state.counters_size = sizeof(global_counters);
+            result = processCheckpointed(global_handle, global_args.pcapfile, global_options.checkpoint_file, global_options.checkpoint_interval,
+                                         state, batchPacket, nullptr);
         }
-        closeInterface(global_handle);
+        else if (time_range)
+        {
+            result = processTimeRange(global_handle, global_args.pcapfile, range_from, range_to, batchPacket, nullptr);
+        }
+        else
+        {
+            pcap_loop(global_handle, 0, batchPacket, nullptr);
+        }
+        return finishRun(result, true);
     }
-    return 0;
+    return finishRun(0, false);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <pcap.h>
 #include <cstring>
+#include <strings.h>
 #include <unistd.h>
 #include <netinet/ip.h>
 #include <netinet/udp.h>
@@ -11,6 +12,7 @@
 #include <fstream>
 #include <map> // Include this header for std::map
 #include <set> // Include this header for std::set
+#include <vector>
 #include <csignal>
 #include <iomanip>
 
@@ -74,3 +76,46 @@ struct dnsHeader {
     uint16_t arcount; // number of resource entries
 };
 
+#define ARENA_SIZE 65536 // a DNS message over UDP never carries more name data than this
+#define MAX_CHAIN_EDGES 32
+#define MAX_CHAIN_ADDRESSES 64
+
+// Bump allocator for strings that only live while one packet is decoded
+struct packetArena {
+    char data[ARENA_SIZE];
+    size_t used;
+};
+
+struct nameEdge {
+    const char *owner;  // CNAME owner
+    const char *target; // canonical name it points to
+};
+
+struct nameAddress {
+    const char *owner; // name of the A/AAAA record
+    const char *ip;
+};
+
+// CNAME records and addresses of one message, resolved to the query names once the message is decoded
+struct nameGraph {
+    nameEdge edges[MAX_CHAIN_EDGES];
+    size_t edge_count;
+    nameAddress addresses[MAX_CHAIN_ADDRESSES];
+    size_t address_count;
+};
+
+// headers of a packet that passed the UDP/53 filter, filled by the decode phase of a batch
+struct decodedPacket {
+    const struct pcap_pkthdr *pkthdr;
+    const u_char *packet;
+    struct ip *ip_header;
+    struct udphdr *udp_header;
+    dnsHeader *dns_header;
+    int dns_header_offset;
+};
+
+// counters reported by printStatistics at the end of the run
+struct monitorCounters {
+    uint64_t watchlist_matches; // question names found on the watchlist
+    uint64_t duplicates;        // copies dropped by the dedup filter
+};
@@ -0,0 +1,87 @@
+// Example consumer of the ring published by dns-monitor --publish <name>.
+// Prints one line per message: time, addresses, id, question and RCODE.
+//
+// usage: dns-ring-reader <name> [--from-start]
+
+#include "RingReader.h"
+
+#include <iostream>
+#include <cstring>
+#include <csignal>
+#include <ctime>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#define POLL_INTERVAL_US 1000
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void stopReader(int)
+{
+    stop_requested = 1;
+}
+
+static void printRecord(const dnsRingRecord &record)
+{
+    char src[INET6_ADDRSTRLEN];
+    char dst[INET6_ADDRSTRLEN];
+    inet_ntop(record.family, record.src, src, sizeof(src));
+    inet_ntop(record.family, record.dst, dst, sizeof(dst));
+
+    char date[32];
+    time_t seconds = record.ts_sec;
+    struct tm local;
+    localtime_r(&seconds, &local);
+    std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &local);
+
+    char line[512];
+    std::snprintf(line, sizeof(line), "%s.%06d %s:%u -> %s:%u %c id=%04x %s type=%u rcode=%u%s",
+                  date, record.ts_usec, src, record.src_port, dst, record.dst_port,
+                  (record.flags & 0x8000) ? 'R' : 'Q', record.id,
+                  record.qname_length > 0 ? record.qname : "-", record.qtype, record.flags & 0x000f,
+                  record.watchlisted ? " [watchlist]" : "");
+    std::cout << line << '\n';
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || (argc == 3 && std::strcmp(argv[2], "--from-start") != 0) || argc > 3)
+    {
+        std::cerr << "usage: " << argv[0] << " <name> [--from-start]" << std::endl;
+        return 1;
+    }
+
+    dnsRingReader reader;
+    if (!openRingReader(reader, argv[1], argc == 3))
+    {
+        return 1;
+    }
+    signal(SIGINT, stopReader);
+    signal(SIGTERM, stopReader);
+
+    uint64_t records = 0;
+    dnsRingRecord record;
+    while (!stop_requested)
+    {
+        RING_READ_RESULT result = readRingRecord(reader, record);
+        if (result == RING_RECORD)
+        {
+            printRecord(record);
+            records++;
+        }
+        else if (result == RING_CLOSED)
+        {
+            break;
+        }
+        else
+        {
+            std::cout.flush();
+            usleep(POLL_INTERVAL_US);
+        }
+    }
+    std::cout.flush();
+
+    std::cerr << "Records read: " << records << ", lost: " << reader.lost << std::endl;
+    closeRingReader(reader);
+    return 0;
+}
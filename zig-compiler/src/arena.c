@@ -0,0 +1,117 @@
+/**
+ * @file arena.c
+ * @brief Implementation of the arena (region) allocator.
+ *
+ * An arena is a linked list of chunks. Allocations bump the used counter of the current chunk,
+ * when it is full the next chunk is reused or a new one is appended. Releasing to a mark just
+ * moves the current chunk and its used counter back, so a statement-by-statement release
+ * of the scratch arena doesn't call free() at all.
+ *
+ * @authors
+ * - Igor Lacko [xlackoi00]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "error.h"
+
+Arena token_arena = {NULL, NULL};
+Arena symbol_arena = {NULL, NULL};
+Arena scratch_arena = {NULL, NULL};
+
+static ArenaChunk *NewArenaChunk(size_t size)
+{
+    ArenaChunk *chunk;
+    if ((chunk = malloc(sizeof(ArenaChunk) + size)) == NULL)
+    {
+        ErrorExit(ERROR_INTERNAL, "Memory allocation failed");
+    }
+
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+void *ArenaAlloc(Arena *arena, size_t size)
+{
+    // round up so the next allocation stays aligned
+    size = (size + ARENA_ALIGNMENT - 1) & ~((size_t)ARENA_ALIGNMENT - 1);
+
+    if (arena->current == NULL)
+    {
+        arena->first = arena->current = NewArenaChunk(size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE);
+    }
+
+    // move to the next chunk (reused after a release) until the request fits
+    while (arena->current->used + size > arena->current->size)
+    {
+        if (arena->current->next == NULL)
+        {
+            arena->current->next = NewArenaChunk(size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE);
+        }
+
+        arena->current = arena->current->next;
+        arena->current->used = 0;
+    }
+
+    void *memory = arena->current->data + arena->current->used;
+    arena->current->used += size;
+    return memory;
+}
+
+char *ArenaStrdup(Arena *arena, const char *string)
+{
+    return ArenaStrndup(arena, string, strlen(string));
+}
+
+char *ArenaStrndup(Arena *arena, const char *string, size_t length)
+{
+    char *copy = ArenaAlloc(arena, length + 1);
+    memcpy(copy, string, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+ArenaMark ArenaGetMark(Arena *arena)
+{
+    ArenaMark mark = {arena->current, arena->current == NULL ? 0 : arena->current->used};
+    return mark;
+}
+
+void ArenaRelease(Arena *arena, ArenaMark mark)
+{
+    // nothing was allocated when the mark was taken, start over from the first chunk
+    if (mark.chunk == NULL)
+    {
+        arena->current = arena->first;
+        if (arena->current != NULL)
+            arena->current->used = 0;
+        return;
+    }
+
+    arena->current = mark.chunk;
+    arena->current->used = mark.used;
+}
+
+void DestroyArena(Arena *arena)
+{
+    ArenaChunk *chunk = arena->first;
+    while (chunk != NULL)
+    {
+        ArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    arena->first = arena->current = NULL;
+}
+
+void DestroyArenas(void)
+{
+    DestroyArena(&token_arena);
+    DestroyArena(&symbol_arena);
+    DestroyArena(&scratch_arena);
+}
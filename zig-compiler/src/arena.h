@@ -0,0 +1,69 @@
+/**
+ * @file arena.h
+ * @brief Arena (region) allocator for the many small, short-lived allocations of the compiler.
+ *
+ * Instead of a malloc/free pair per token, symbol or string, objects with the same lifetime
+ * are carved from large chunks and released together. There are three arenas:
+ * - token_arena: the token stream and the token attributes, lives for the whole compilation
+ * - symbol_arena: variable and function symbols and their names/values, lives for the whole compilation
+ * - scratch_arena: token copies and artificial tokens of expression parsing, released after every statement
+ *
+ * @authors
+ * - Igor Lacko [xlackoi00]
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+#define ARENA_CHUNK_SIZE 65536 // bytes, bigger requests get a chunk of their own size
+#define ARENA_ALIGNMENT 8      // alignment of every allocation, enough for the pointers in tokens and symbols
+
+extern Arena token_arena;
+extern Arena symbol_arena;
+extern Arena scratch_arena;
+
+/**
+ * @brief Allocates uninitialized memory from the arena, never returns NULL
+ *
+ * @param arena Arena to allocate from
+ * @param size Number of bytes
+ * @return void*: Pointer valid until the arena is released past it or destroyed
+ */
+void *ArenaAlloc(Arena *arena, size_t size);
+
+/**
+ * @brief Copies a null terminated string into the arena
+ *
+ * @param arena Arena to allocate from
+ * @param string String to copy
+ * @return char*: The copy
+ */
+char *ArenaStrdup(Arena *arena, const char *string);
+
+/**
+ * @brief Copies length characters into the arena and terminates them
+ *
+ * @param arena Arena to allocate from
+ * @param string Start of the characters, doesn't have to be null terminated
+ * @param length Number of characters to copy
+ * @return char*: The null terminated copy
+ */
+char *ArenaStrndup(Arena *arena, const char *string, size_t length);
+
+// Returns the current position in the arena
+ArenaMark ArenaGetMark(Arena *arena);
+
+// Releases everything allocated after the mark, the chunks are kept for reuse
+void ArenaRelease(Arena *arena, ArenaMark mark);
+
+// Frees all chunks of the arena
+void DestroyArena(Arena *arena);
+
+// Frees all three arenas, registered with atexit() so every exit path releases them
+void DestroyArenas(void);
+
+#endif
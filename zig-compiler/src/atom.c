@@ -0,0 +1,107 @@
+/**
+ * @file atom.c
+ * @brief Implementation of the global atom table.
+ *
+ * The table is a hash table with open addressing over pointers to atoms, which live in token_arena
+ * right after their hash and length. The hash is the same sdbm variant the symtable always used,
+ * so symbols keep their positions in the symtables.
+ *
+ * @authors
+ * - Igor Lacko [xlackoi00]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "atom.h"
+#include "arena.h"
+#include "error.h"
+
+static Atom **atom_table = NULL;
+static unsigned long atom_capacity = 0;
+static unsigned long atom_count = 0;
+
+static unsigned int HashString(const char *string, size_t length)
+{
+    unsigned int hash = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = 65599 * hash + (unsigned char)string[i];
+    }
+
+    return hash;
+}
+
+static void GrowAtomTable(void)
+{
+    unsigned long capacity = atom_capacity == 0 ? ATOM_TABLE_SIZE : atom_capacity * 2;
+    Atom **table = calloc(capacity, sizeof(Atom *));
+    if (!table)
+    {
+        ErrorExit(ERROR_INTERNAL, "Memory allocation failed");
+    }
+
+    // the capacity is a power of two, so the slot is the low bits of the stored hash
+    for (unsigned long i = 0; i < atom_capacity; i++)
+    {
+        if (atom_table[i] == NULL)
+            continue;
+
+        unsigned long index = atom_table[i]->hash & (capacity - 1);
+        while (table[index] != NULL)
+            index = (index + 1) & (capacity - 1);
+
+        table[index] = atom_table[i];
+    }
+
+    free(atom_table);
+    atom_table = table;
+    atom_capacity = capacity;
+}
+
+char *InternString(const char *string, size_t length)
+{
+    if ((atom_count + 1) * 2 > atom_capacity)
+        GrowAtomTable();
+
+    unsigned int hash = HashString(string, length);
+    unsigned long index = hash & (atom_capacity - 1);
+
+    while (atom_table[index] != NULL)
+    {
+        Atom *atom = atom_table[index];
+        if (atom->hash == hash && atom->length == length && !memcmp(atom->name, string, length))
+            return atom->name;
+
+        index = (index + 1) & (atom_capacity - 1);
+    }
+
+    // first occurence of the string
+    Atom *atom = ArenaAlloc(&token_arena, sizeof(Atom) + length + 1);
+    atom->hash = hash;
+    atom->length = length;
+    memcpy(atom->name, string, length);
+    atom->name[length] = '\0';
+
+    atom_table[index] = atom;
+    atom_count++;
+    return atom->name;
+}
+
+char *Intern(const char *string)
+{
+    return InternString(string, strlen(string));
+}
+
+unsigned int GetAtomHash(const char *atom)
+{
+    return ((const Atom *)(atom - offsetof(Atom, name)))->hash;
+}
+
+void DestroyAtomTable(void)
+{
+    free(atom_table);
+    atom_table = NULL;
+    atom_capacity = atom_count = 0;
+}
@@ -0,0 +1,41 @@
+/**
+ * @file atom.h
+ * @brief Global atom table, interns the strings of token attributes and symbol names.
+ *
+ * Every distinct string is stored exactly once, so two atoms are equal if and only if they are the
+ * same pointer, and the hash used by the symtables is computed once when the string is interned.
+ * The scanner interns the attribute of every token, symbol names are the attributes of the tokens
+ * that declared them, so the symtable only ever compares pointers.
+ *
+ * @authors
+ * - Igor Lacko [xlackoi00]
+ */
+
+#ifndef ATOM_H
+#define ATOM_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+#define ATOM_TABLE_SIZE 1024 // initial number of slots, doubled when the table is half full
+
+/**
+ * @brief Returns the atom for length characters of string, adding it to the table if needed
+ *
+ * @param string Characters of the string, don't have to be null terminated
+ * @param length Number of characters
+ * @return char*: Null terminated atom, lives in token_arena until the end of the compilation
+ */
+char *InternString(const char *string, size_t length);
+
+// InternString() for a null terminated string
+char *Intern(const char *string);
+
+// Returns the hash stored with an atom, atom has to be a pointer returned by InternString()
+unsigned int GetAtomHash(const char *atom);
+
+// Frees the slots of the atom table, the atoms themselves are released with token_arena
+void DestroyAtomTable(void);
+
+#endif
@@ -90,9 +90,8 @@ void PUSHS(const char *attribute, TOKEN_TYPE type, FRAME frame)
     // If the token is an identifier, push it from the correct frame
     if (type == IDENTIFIER_TOKEN)
     {
-        char *frame_string = GetFrameString(frame);
+        const char *frame_string = GetFrameString(frame);
         fprintf(stdout, "PUSHS %s%s\n", frame_string, attribute);
-        free(frame_string);
         return;
     }
 
@@ -103,7 +102,7 @@ void PUSHS(const char *attribute, TOKEN_TYPE type, FRAME frame)
         return;
     }
 
-    char *type_string = GetTypeStringToken(type);
+    const char *type_string = GetTypeStringToken(type);
     fprintf(stdout, "PUSHS %s", type_string);
 
     // White space handling for string literals
@@ -118,12 +117,11 @@ void PUSHS(const char *attribute, TOKEN_TYPE type, FRAME frame)
     }
 
     fprintf(stdout, "\n");
-    free(type_string);
 }
 
 void MOVE(Token *dst, Token *src, FRAME dst_frame)
 {
-    char *frame_string = GetFrameString(dst_frame);
+    const char *frame_string = GetFrameString(dst_frame);
     fprintf(stdout, "MOVE %s%s ", frame_string, dst->attribute);
     if (src->token_type == LITERAL_TOKEN)
         WriteStringLiteral(src->attribute);
@@ -141,7 +139,7 @@ void SETPARAM(int order, const char *value, TOKEN_TYPE type, FRAME frame)
     fprintf(stdout, "MOVE TF@PARAM%d ", order);
 
     // Prefix is either GF@/LF@/TF@ or the type of the token (int@, float@0x, string@, bool@)
-    char *prefix = type == IDENTIFIER_TOKEN ? GetFrameString(frame) : GetTypeStringToken(type);
+    const char *prefix = type == IDENTIFIER_TOKEN ? GetFrameString(frame) : GetTypeStringToken(type);
     fprintf(stdout, "%s", prefix);
 
     // If the token is a string literal, call the WriteStringLiteral function to handle whitespaces accordingly
@@ -153,66 +151,64 @@ void SETPARAM(int order, const char *value, TOKEN_TYPE type, FRAME frame)
         fprintf(stdout, "%s", value);
 
     fprintf(stdout, "\n");
-
-    free(prefix);
 }
 
-char *GetFrameString(FRAME frame)
+const char *GetFrameString(FRAME frame)
 {
     switch (frame)
     {
     case GLOBAL_FRAME:
-        return strdup("GF@");
+        return "GF@";
 
     case LOCAL_FRAME:
-        return strdup("LF@");
+        return "LF@";
 
     case TEMPORARY_FRAME:
-        return strdup("TF@");
+        return "TF@";
     }
 
     return NULL; // Shut up GCC please
 }
 
-char *GetTypeStringToken(TOKEN_TYPE type)
+const char *GetTypeStringToken(TOKEN_TYPE type)
 {
     switch (type)
     {
     case INTEGER_32:
-        return strdup("int@");
+        return "int@";
 
     case DOUBLE_64:
-        return strdup("float@");
+        return "float@";
 
     case LITERAL_TOKEN:
-        return strdup("string@");
+        return "string@";
 
     case BOOLEAN_TOKEN:
-        return strdup("bool@");
+        return "bool@";
 
     default:
         return NULL;
     }
 }
 
-char *GetTypeStringSymbol(DATA_TYPE type)
+const char *GetTypeStringSymbol(DATA_TYPE type)
 {
     switch (type)
     {
     case INT32_TYPE:
     case INT32_NULLABLE_TYPE:
-        return strdup("int@");
+        return "int@";
 
     case DOUBLE64_TYPE:
     case DOUBLE64_NULLABLE_TYPE:
-        return strdup("float@0x");
+        return "float@0x";
 
     case U8_ARRAY_TYPE:
     case U8_ARRAY_NULLABLE_TYPE:
-        return strdup("string@");
+        return "string@";
 
     case BOOLEAN:
-        return strdup("bool@");
+        return "bool@";
 
     default:
         return NULL;
@@ -224,26 +220,26 @@ void READ(VariableSymbol *var, FRAME frame, DATA_TYPE read_type)
 {
     if (var == NULL)
         return;
-    char *type;
+    const char *type;
     switch (var->type)
     {
     case U8_ARRAY_TYPE:
     case U8_ARRAY_NULLABLE_TYPE:
-        type = strdup("string");
+        type = "string";
         break;
 
     case INT32_TYPE:
     case INT32_NULLABLE_TYPE:
-        type = strdup("int");
+        type = "int";
         break;
 
     case DOUBLE64_TYPE:
     case DOUBLE64_NULLABLE_TYPE:
-        type = strdup("float");
+        type = "float";
         break;
 
     case BOOLEAN:
-        type = strdup("bool");
+        type = "bool";
         break;
 
     case VOID_TYPE:
@@ -268,14 +264,12 @@ void READ(VariableSymbol *var, FRAME frame, DATA_TYPE read_type)
         fprintf(stdout, "READ TF@%s %s\n", var->name, type);
         break;
     }
-
-    free(type);
 }
 
 void WRITEINSTRUCTION(Token *token, FRAME frame)
 {
     // Get the prefix and print it
-    char *prefix = token->token_type == IDENTIFIER_TOKEN ? GetFrameString(frame) : GetTypeStringToken(token->token_type);
+    const char *prefix = token->token_type == IDENTIFIER_TOKEN ? GetFrameString(frame) : GetTypeStringToken(token->token_type);
     fprintf(stdout, "WRITE %s", prefix);
 
     // Write the token attribute depenting on the type
@@ -286,37 +280,29 @@ void WRITEINSTRUCTION(Token *token, FRAME frame)
     else
         fprintf(stdout, "%s", token->attribute);
     fprintf(stdout, "\n");
-
-    free(prefix);
 }
 
 void INT2FLOAT(VariableSymbol *dst, Token *value, FRAME dst_frame, FRAME src_frame)
 {
     if (dst == NULL)
         return;
-    char *src_prefix = value->token_type == IDENTIFIER_TOKEN ? GetFrameString(src_frame) : strdup("int@");
-    char *dst_prefix = GetFrameString(dst_frame);
+    const char *src_prefix = value->token_type == IDENTIFIER_TOKEN ? GetFrameString(src_frame) : "int@";
+    const char *dst_prefix = GetFrameString(dst_frame);
 
     fprintf(stdout, "INT2FLOAT %s%s %s%s\n", dst_prefix, dst->name, src_prefix, value->attribute);
-
-    free(src_prefix);
-    free(dst_prefix);
 }
 
 void FLOAT2INT(VariableSymbol *dst, Token *value, FRAME dst_frame, FRAME src_frame)
 {
     if (dst == NULL)
         return;
-    char *src_prefix = value->token_type == IDENTIFIER_TOKEN ? GetFrameString(src_frame) : strdup("float@0x");
-    char *dst_prefix = GetFrameString(dst_frame);
+    const char *src_prefix = value->token_type == IDENTIFIER_TOKEN ? GetFrameString(src_frame) : "float@0x";
+    const char *dst_prefix = GetFrameString(dst_frame);
 
     if (value->token_type == IDENTIFIER_TOKEN)
         fprintf(stdout, "FLOAT2INT %s%s %s%s\n", dst_prefix, dst->name, src_prefix, value->attribute);
     else
         fprintf(stdout, "FLOAT2INT %s%s %s%a\n", dst_prefix, dst->name, src_prefix, strtod(value->attribute, NULL));
-
-    free(src_prefix);
-    free(dst_prefix);
 }
 
 void STRLEN(VariableSymbol *var, Token *src, FRAME dst_frame, FRAME src_frame)
@@ -324,13 +310,11 @@ void STRLEN(VariableSymbol *var, Token *src, FRAME dst_frame, FRAME src_frame)
     if (var == NULL)
         return;
     // Get the prefixes
-    char *dst_prefix = GetFrameString(dst_frame);
-    char *src_prefix = src->token_type == IDENTIFIER_TOKEN ? GetFrameString(src_frame) : strdup("string@");
+    const char *dst_prefix = GetFrameString(dst_frame);
+    const char *src_prefix = src->token_type == IDENTIFIER_TOKEN ? GetFrameString(src_frame) : "string@";
     fprintf(stdout, "STRLEN %s%s %s%s\n", dst_prefix, var->name, src_prefix, src->attribute);
 
     // Free the prefixes
-    free(dst_prefix);
-    free(src_prefix);
 }
 
 void CONCAT(VariableSymbol *dst, Token *prefix, Token *postfix, FRAME dst_frame, FRAME prefix_frame, FRAME postfix_frame)
@@ -338,17 +322,14 @@ void CONCAT(VariableSymbol *dst, Token *prefix, Token *postfix, FRAME dst_frame,
     if (dst == NULL)
         return;
     // Get the prefixes (maybe choose different variable names)
-    char *dst_prefix = GetFrameString(dst_frame);
-    char *prefix_prefix = prefix->token_type == IDENTIFIER_TOKEN ? GetFrameString(prefix_frame) : strdup("string@");
-    char *postfix_prefix = postfix->token_type == IDENTIFIER_TOKEN ? GetFrameString(postfix_frame) : strdup("string@");
+    const char *dst_prefix = GetFrameString(dst_frame);
+    const char *prefix_prefix = prefix->token_type == IDENTIFIER_TOKEN ? GetFrameString(prefix_frame) : "string@";
+    const char *postfix_prefix = postfix->token_type == IDENTIFIER_TOKEN ? GetFrameString(postfix_frame) : "string@";
 
     // Print the instruction
     fprintf(stdout, "CONCAT %s%s %s%s %s%s\n", dst_prefix, dst->name, prefix_prefix, prefix->attribute, postfix_prefix, postfix->attribute);
 
     // Free the prefixes
-    free(dst_prefix);
-    free(prefix_prefix);
-    free(postfix_prefix);
 }
 
 void STRI2INT(VariableSymbol *var, Token *src, Token *position, FRAME dst_frame, FRAME src_frame, FRAME position_frame)
@@ -356,17 +337,14 @@ void STRI2INT(VariableSymbol *var, Token *src, Token *position, FRAME dst_frame,
     if (var == NULL)
         return;
     // Get the prefixes first
-    char *dst_prefix = GetFrameString(dst_frame);
-    char *src_prefix = src->token_type == IDENTIFIER_TOKEN ? GetFrameString(src_frame) : strdup("string@");
-    char *position_prefix = position->token_type == IDENTIFIER_TOKEN ? GetFrameString(position_frame) : strdup("int@");
+    const char *dst_prefix = GetFrameString(dst_frame);
+    const char *src_prefix = src->token_type == IDENTIFIER_TOKEN ? GetFrameString(src_frame) : "string@";
+    const char *position_prefix = position->token_type == IDENTIFIER_TOKEN ? GetFrameString(position_frame) : "int@";
 
     // We assume that the type-checking has already been done, so error 58 won't occur
     fprintf(stdout, "STRI2INT %s%s %s%s %s%s\n", dst_prefix, var->name, src_prefix, src->attribute, position_prefix, position->attribute);
 
     // Deallocate the prefixes
-    free(dst_prefix);
-    free(src_prefix);
-    free(position_prefix);
 }
 
 void INT2CHAR(VariableSymbol *dst, Token *value, FRAME dst_frame, FRAME src_frame)
@@ -374,13 +352,11 @@ void INT2CHAR(VariableSymbol *dst, Token *value, FRAME dst_frame, FRAME src_fram
     if (dst == NULL)
         return;
     // Get prefixes
-    char *dst_prefix = GetFrameString(dst_frame);
-    char *src_prefix = value->token_type == IDENTIFIER_TOKEN ? GetFrameString(src_frame) : strdup("int@");
+    const char *dst_prefix = GetFrameString(dst_frame);
+    const char *src_prefix = value->token_type == IDENTIFIER_TOKEN ? GetFrameString(src_frame) : "int@";
     fprintf(stdout, "INT2CHAR %s%s %s%s\n", dst_prefix, dst->name, src_prefix, value->attribute);
 
     // Free the prefixes
-    free(dst_prefix);
-    free(src_prefix);
 }
 
 void STRCMP(VariableSymbol *var, Token *str1, Token *str2, FRAME dst_frame, FRAME str1_frame, FRAME str2_frame)
@@ -388,10 +364,10 @@ void STRCMP(VariableSymbol *var, Token *str1, Token *str2, FRAME dst_frame, FRAM
     if (var == NULL)
         return;
     // If this is being called, we assume that the needed type-checking has already been done so it won't be done here
-    char *dst_frame_str = GetFrameString(dst_frame);
+    const char *dst_frame_str = GetFrameString(dst_frame);
     (void)dst_frame_str;
-    char *str1_prefix = str1->token_type == IDENTIFIER_TOKEN ? GetFrameString(str1_frame) : GetTypeStringToken(str1->token_type);
-    char *str2_prefix = str2->token_type == IDENTIFIER_TOKEN ? GetFrameString(str2_frame) : GetTypeStringToken(str2->token_type);
+    const char *str1_prefix = str1->token_type == IDENTIFIER_TOKEN ? GetFrameString(str1_frame) : GetTypeStringToken(str1->token_type);
+    const char *str2_prefix = str2->token_type == IDENTIFIER_TOKEN ? GetFrameString(str2_frame) : GetTypeStringToken(str2->token_type);
 
     // Compare the strings with IFJcode24 instructions
     // B1 will store the strings s1 > s2, B2 will store s2 > s1, if neither of those is true, the strings are equal
@@ -461,8 +437,8 @@ void STRING(VariableSymbol *var, Token *src, FRAME dst_frame, FRAME src_frame)
 {
     if (var == NULL)
         return;
-    char *dst_prefix = GetFrameString(dst_frame);
-    char *src_prefix = src->token_type == IDENTIFIER_TOKEN ? GetFrameString(src_frame) : strdup("string@");
+    const char *dst_prefix = GetFrameString(dst_frame);
+    const char *src_prefix = src->token_type == IDENTIFIER_TOKEN ? GetFrameString(src_frame) : "string@";
     fprintf(stdout, "MOVE %s%s %s", dst_prefix, var->name, src_prefix);
     if (src->token_type == LITERAL_TOKEN)
     {
@@ -471,8 +447,6 @@ void STRING(VariableSymbol *var, Token *src, FRAME dst_frame, FRAME src_frame)
     }
     else
         fprintf(stdout, "%s\n", src->attribute);
-    free(dst_prefix);
-    free(src_prefix);
 }
 
 void ORD(VariableSymbol *var, Token *string, Token *position, FRAME dst_frame, FRAME string_frame, FRAME position_frame)
@@ -480,9 +454,9 @@ void ORD(VariableSymbol *var, Token *string, Token *position, FRAME dst_frame, F
     if (var == NULL)
         return;
     // Get the prefixes first
-    char *dst_prefix = GetFrameString(dst_frame);
-    char *string_prefix = string->token_type == IDENTIFIER_TOKEN ? GetFrameString(string_frame) : strdup("string@");
-    char *position_prefix = position->token_type == IDENTIFIER_TOKEN ? GetFrameString(position_frame) : strdup("int@");
+    const char *dst_prefix = GetFrameString(dst_frame);
+    const char *string_prefix = string->token_type == IDENTIFIER_TOKEN ? GetFrameString(string_frame) : "string@";
+    const char *position_prefix = position->token_type == IDENTIFIER_TOKEN ? GetFrameString(position_frame) : "int@";
 
     // We assume that the type-checking has already been done
     /*
@@ -526,9 +500,6 @@ void ORD(VariableSymbol *var, Token *string, Token *position, FRAME dst_frame, F
     fprintf(stdout, "LABEL ENDORD%d\n", ord_count);
 
     // Deallocate the resources
-    free(dst_prefix);
-    free(string_prefix);
-    free(position_prefix);
 
     // Increment the ord counter
     ord_count++;
@@ -539,10 +510,10 @@ void SUBSTRING(VariableSymbol *var, Token *str, Token *beginning_index, Token *e
     if (var == NULL)
         return;
     // Get all the prefixes first
-    char *dst_prefix = GetFrameString(dst_frame);
-    char *str_prefix = GetFrameString(src_frame);
-    char *beginning_prefix = beginning_index->token_type == IDENTIFIER_TOKEN ? GetFrameString(beginning_frame) : strdup("int@");
-    char *end_prefix = end_index->token_type == IDENTIFIER_TOKEN ? GetFrameString(end_frame) : strdup("int@");
+    const char *dst_prefix = GetFrameString(dst_frame);
+    const char *str_prefix = GetFrameString(src_frame);
+    const char *beginning_prefix = beginning_index->token_type == IDENTIFIER_TOKEN ? GetFrameString(beginning_frame) : "int@";
+    const char *end_prefix = end_index->token_type == IDENTIFIER_TOKEN ? GetFrameString(end_frame) : "int@";
 
     /* First, check the edge cases. The function ifj.substring(str, beginning_index, end_index) returns null when:
         1. beginning_index < 0
@@ -158,13 +158,13 @@ void PUSHS(const char *attribute, TOKEN_TYPE type, FRAME frame);
 void SETPARAM(int order, const char *value, TOKEN_TYPE type, FRAME frame);
 
 // Makes the print instructions a bit less bloated
-char *GetFrameString(FRAME frame);
+const char *GetFrameString(FRAME frame);
 
 // Gets a IFJ24Code data type from a token type
-char *GetTypeStringToken(TOKEN_TYPE type);
+const char *GetTypeStringToken(TOKEN_TYPE type);
 
 // Gets a IFJ24Code data type from a data type
-char *GetTypeStringSymbol(DATA_TYPE type);
+const char *GetTypeStringSymbol(DATA_TYPE type);
 
 // Generates pop into R0/F0/B0 depending on the expression type
 void PopToRegister(DATA_TYPE type);
@@ -144,7 +144,7 @@ void ParseIfStatement(Parser *parser)
     ElseLabel(if_id);
 
     // Pop the if body symtable
-    SymtableStackPush(parser->symtable_stack, InitSymtable(TABLE_COUNT));
+    SymtableStackPush(parser->symtable_stack, InitSymtable(SCOPE_TABLE_COUNT));
     parser->symtable = SymtableStackTop(parser->symtable_stack);
 
     // Else body
@@ -224,7 +224,7 @@ void ParseNullableIfStatement(Parser *parser)
     VariableSymbol *new = VariableSymbolInit();
     new->defined = true;
     new->is_const = false;
-    new->name = strdup(token->attribute);
+    new->name = token->attribute;
     new->type = NullableToNormal(var->type);
 
     // New entry in the symtable
@@ -258,7 +258,7 @@ void ParseNullableIfStatement(Parser *parser)
     ElseLabel(if_id);
 
     // Pop the if body symtable
-    SymtableStackPush(parser->symtable_stack, InitSymtable(TABLE_COUNT));
+    SymtableStackPush(parser->symtable_stack, InitSymtable(SCOPE_TABLE_COUNT));
     parser->symtable = SymtableStackTop(parser->symtable_stack);
 
     // Else body
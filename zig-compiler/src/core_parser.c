@@ -29,6 +29,8 @@
 #include "stack.h"
 #include "loop.h"
 #include "conditionals.h"
+#include "arena.h"
+#include "atom.h"
 
 Parser InitParser()
 {
@@ -40,7 +42,7 @@ Parser InitParser()
             .end_of_program = false,
             .line_number = 1,
             .nested_level = 0,
-            .symtable = InitSymtable(TABLE_COUNT),
+            .symtable = InitSymtable(SCOPE_TABLE_COUNT),
             .symtable_stack = SymtableStackInit(),
             .parsing_functions = true};
 
@@ -276,7 +278,7 @@ void Header(Parser *parser)
 // if(expression){}else{}
 void IfElse(Parser *parser)
 {
-    Symtable *symtable = InitSymtable(TABLE_COUNT);
+    Symtable *symtable = InitSymtable(SCOPE_TABLE_COUNT);
     SymtableStackPush(parser->symtable_stack, symtable);
     parser->symtable = symtable;
 
@@ -289,7 +291,7 @@ void IfElse(Parser *parser)
 
 void WhileLoop(Parser *parser)
 {
-    Symtable *symtable = InitSymtable(TABLE_COUNT);
+    Symtable *symtable = InitSymtable(SCOPE_TABLE_COUNT);
     SymtableStackPush(parser->symtable_stack, symtable);
     parser->symtable = symtable;
 
@@ -308,7 +310,7 @@ void VarDeclaration(Parser *parser, bool is_const)
 
     // add to symtable
     VariableSymbol *var = VariableSymbolInit();
-    var->name = strdup(token->attribute);
+    var->name = token->attribute;
     var->is_const = is_const;
     var->type = VOID_TYPE;
 
@@ -381,7 +383,7 @@ bool ConstValueAssignment(VariableSymbol *var)
         case INTEGER_32:
             if (var->type == INT32_TYPE || var->type == INT32_NULLABLE_TYPE || var->type == VOID_TYPE)
             {
-                var->value = strdup(potential_value->attribute);
+                var->value = potential_value->attribute;
                 stream_index += 2;
                 fprintf(stdout, "MOVE LF@%s int@%s\n", var->name, var->value);
                 return true;
@@ -392,7 +394,7 @@ bool ConstValueAssignment(VariableSymbol *var)
         case DOUBLE_64:
             if (var->type == DOUBLE64_TYPE || var->type == DOUBLE64_NULLABLE_TYPE || var->type == VOID_TYPE)
             {
-                var->value = strdup(potential_value->attribute);
+                var->value = potential_value->attribute;
                 stream_index += 2;
                 fprintf(stdout, "MOVE LF@%s float@%a\n", var->name, strtod(var->value, NULL));
                 return true;
@@ -403,7 +405,7 @@ bool ConstValueAssignment(VariableSymbol *var)
         case KEYWORD:
             if (potential_value->keyword_type == NULL_TYPE && var->nullable)
             {
-                var->value = strdup(potential_value->attribute);
+                var->value = potential_value->attribute;
                 stream_index += 2;
                 fprintf(stdout, "MOVE LF@%s nil@nil\n", var->name);
                 return true;
@@ -577,7 +579,7 @@ void FunctionDefinition(Parser *parser)
         continue;
 
     // Create a new symtable for the function's stack frame
-    Symtable *symtable = InitSymtable(TABLE_COUNT);
+    Symtable *symtable = InitSymtable(SCOPE_TABLE_COUNT);
     SymtableStackPush(parser->symtable_stack, symtable);
     parser->symtable = symtable;
 
@@ -1191,8 +1193,13 @@ void ProgramBody(Parser *parser)
     FunctionSymbol *func;
     VariableSymbol *var;
 
+    // Token copies and artificial tokens of a statement are released when the statement ends,
+    // nested blocks take their marks later so they never release what an outer statement still uses
+    ArenaMark statement_mark = ArenaGetMark(&scratch_arena);
+
     while (true)
     {
+        ArenaRelease(&scratch_arena, statement_mark);
         token = GetNextToken(parser);
         // Code can't be outside of a function, so if we aren't in a function the next token has to be pub
 
@@ -1277,15 +1284,14 @@ void ProgramBody(Parser *parser)
 
             else if (IsFunctionCall(parser))
             {
-                // Store the function name in a temporary variable since we will be moving the tokens forward
-                char *tmp_func_name = strdup(token->attribute);
+                // Keep the function name, the stream tokens stay in token_arena while we move forward
+                char *tmp_func_name = token->attribute;
 
                 // Move past the ID(
                 stream_index += 2;
 
                 // Function call
                 FunctionCall(parser, FindFunctionSymbol(parser->global_symtable, tmp_func_name), tmp_func_name, VOID_TYPE);
-                free(tmp_func_name);
             }
 
             // Check for an undefinded variable case
@@ -1346,6 +1352,10 @@ void PrintEqualTokens()
 
 int main()
 {
+    // release the token, symbol and scratch arenas on every exit path, including ErrorExit()
+    atexit(DestroyArenas);
+    atexit(DestroyAtomTable);
+
     // parser instance
     Parser parser = InitParser();
 
@@ -26,8 +26,23 @@
 #include "vector.h"
 #include "codegen.h"
 #include "scanner.h"
+#include "atom.h"
 
 // ifj.function(params)
+int GetEmbeddedFunctionIndex(const char *name)
+{
+    size_t length = strlen(name);
+    if (length == 0 || length >= MAXLENGTH_EMBEDDED_FUNCTION)
+        return -1;
+
+    // one probe into the perfect hash, then compare with the only name that can match
+    int index = embedded_hash_table[NAME_HASH(name, length)];
+    if (index == -1 || embedded_names[index][length] != '\0' || memcmp(embedded_names[index], name, length))
+        return -1;
+
+    return index;
+}
+
 FunctionSymbol *IsEmbeddedFunction(Parser *parser)
 {
     Token *token = GetNextToken(parser);
@@ -51,14 +66,11 @@ FunctionSymbol *IsEmbeddedFunction(Parser *parser)
     }
 
     // Check if it matches a IFJ function first, the user can also type in ifj.myFoo which would be an error
-    for (int i = 0; i < EMBEDDED_FUNCTION_COUNT; i++)
+    if (GetEmbeddedFunctionIndex(token->attribute) != -1) // Match found
     {
-        if (!strcmp(embedded_names[i], token->attribute)) // Match found
-        {
-            FunctionSymbol *func = FindFunctionSymbol(parser->global_symtable, token->attribute);
-            stream_index -= 2; // Move the stream back to the beginning of the embedded function
-            return func;
-        }
+        FunctionSymbol *func = FindFunctionSymbol(parser->global_symtable, token->attribute);
+        stream_index -= 2; // Move the stream back to the beginning of the embedded function
+        return func;
     }
 
     // The identifier was not an embedded function
@@ -75,7 +87,7 @@ void InsertEmbeddedFunctions(Parser *parser)
     {
         // Create a new function symbol
         FunctionSymbol *func = FunctionSymbolInit();
-        func->name = strdup(embedded_names[i]);
+        func->name = Intern(embedded_names[i]);
         func->return_type = embedded_return_types[i];
 
         // Create the function's parameters
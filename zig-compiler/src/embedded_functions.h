@@ -20,6 +20,14 @@
 
 #include "types.h"
 
+/**
+ * @brief Looks up an embedded function name with the perfect hash NAME_HASH from shared.h
+ *
+ * @param name Identifier following "ifj."
+ * @return int Index into embedded_names, -1 if the name isn't an embedded function
+ */
+int GetEmbeddedFunctionIndex(const char *name);
+
 /**
  * @brief Checks if we have a embedded function as the next set of tokens
  *
@@ -24,6 +24,7 @@
 #include "scanner.h"
 #include "codegen.h"
 #include "shared.h"
+#include "arena.h"
 
 const PrecedenceTable precedence_table = {
     /*ID*/ {INVALID, REDUCE, REDUCE, REDUCE, REDUCE, REDUCE, REDUCE, REDUCE, REDUCE, REDUCE, REDUCE, INVALID, REDUCE, REDUCE},
@@ -478,8 +479,8 @@ void ReplaceConstants(TokenVector *postfix, Parser *parser)
             if (var != NULL && !var->nullable && var->is_const && var->value != NULL && var->type == DOUBLE64_TYPE && HasZeroDecimalPlaces(var->value))
             {
                 var->was_used = true;
-                Token *new = InitToken();
-                new->attribute = strdup(var->value);
+                Token *new = InitToken(&scratch_arena);
+                new->attribute = var->value;
                 new->line_number = token->line_number;
                 switch (var->type)
                 {
@@ -1284,7 +1285,7 @@ DATA_TYPE ParseExpression(TokenVector *postfix, Parser *parser)
             /* Now we can push the result back onto the stack
                 - We have to create an artificial token for the result
             */
-            Token *result = InitToken();
+            Token *result = InitToken(&scratch_arena);
             result->token_type = result_type == INT32_TYPE ? INTEGER_32 : DOUBLE_64;
             EvaluationStackPush(stack, result);
 
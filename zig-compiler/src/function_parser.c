@@ -146,7 +146,7 @@ void ParseFunctionDefinition(Parser *parser)
     if ((func = FindFunctionSymbol(parser->global_symtable, token->attribute)) == NULL)
     {
         func = FunctionSymbolInit();
-        func->name = strdup(token->attribute);
+        func->name = token->attribute;
         InsertFunctionSymbol(parser, func);
         parser->current_function = func;
     }
@@ -243,7 +243,7 @@ void ParseParameters(Parser *parser, FunctionSymbol *func)
         {
             AppendToken(stream, token);
             VariableSymbol *var = VariableSymbolInit();
-            var->name = strdup(token->attribute);
+            var->name = token->attribute;
             var->is_const = false;
 
             for (int i = 0; i < func->num_of_parameters; i++)
@@ -191,7 +191,7 @@ void ParseNullableWhileLoop(Parser *parser)
     VariableSymbol *var2 = VariableSymbolInit();
     var2->defined = true;
     var2->is_const = false;
-    var2->name = strdup(token->attribute);
+    var2->name = token->attribute;
     var2->type = NullableToNormal(var->type);
 
     // Closing '|'
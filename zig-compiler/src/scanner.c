@@ -13,18 +13,18 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <stdbool.h>
+#include <sys/stat.h>
 
 #include "scanner.h"
 #include "error.h"
-#include "vector.h"
+#include "arena.h"
+#include "atom.h"
+#include "shared.h"
 
-Token *InitToken()
+Token *InitToken(Arena *arena)
 {
-    Token *token;
-    if ((token = calloc(1, sizeof(Token))) == NULL)
-    {
-        ErrorExit(ERROR_INTERNAL, "Memory allocation failed.");
-    }
+    Token *token = ArenaAlloc(arena, sizeof(Token));
+    memset(token, 0, sizeof(Token));
 
     // set default value and return
     token->keyword_type = NONE;
@@ -33,9 +33,9 @@ Token *InitToken()
 
 Token *CopyToken(Token *token)
 {
-    Token *copy = InitToken();
+    Token *copy = InitToken(&scratch_arena);
 
-    copy->attribute = strdup(token->attribute);
+    copy->attribute = token->attribute; // atoms are never modified, the copy can share it
     copy->token_type = token->token_type;
     copy->keyword_type = token->keyword_type;
     copy->line_number = token->line_number;
@@ -45,21 +45,68 @@ Token *CopyToken(Token *token)
 
 void DestroyToken(Token *token)
 {
-    if (token->attribute != NULL)
+    // the token and its attribute live in token_arena or scratch_arena and are released with it
+    (void)token;
+}
+
+// The whole input, read once by LoadSource(), and the position of the next character in it
+static char *source = NULL;
+static size_t source_length = 0;
+static size_t source_position = 0;
+static bool source_loaded = false;
+
+void LoadSource()
+{
+    // a regular file can be read into a buffer of its exact size, pipes grow the buffer as needed
+    size_t capacity = SOURCE_CHUNK_SIZE;
+    struct stat info;
+    if (fstat(fileno(stdin), &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+        capacity = (size_t)info.st_size + 1;
+
+    // one extra byte so a number at the very end can be terminated in place
+    if ((source = malloc(capacity + 1)) == NULL)
+        ErrorExit(ERROR_INTERNAL, "Memory allocation failed");
+
+    size_t read;
+    while ((read = fread(source + source_length, sizeof(char), capacity - source_length, stdin)) > 0)
     {
-        free(token->attribute);
-        token->attribute = NULL;
+        source_length += read;
+        if (source_length == capacity)
+        {
+            capacity *= 2;
+            if ((source = realloc(source, capacity + 1)) == NULL)
+                ErrorExit(ERROR_INTERNAL, "Memory allocation failed");
+        }
     }
 
-    free(token);
-    token = NULL;
+    source[source_length] = '\0';
+    source_position = 0;
+    source_loaded = true;
+}
+
+void DestroySource()
+{
+    free(source);
+    source = NULL;
+    source_length = source_position = 0;
+}
+
+// Counterpart of getchar(), returns the next character of the source and moves past it
+static int ReadChar()
+{
+    return source_position < source_length ? (unsigned char)source[source_position++] : EOF;
+}
+
+// Counterpart of ungetc(), EOF isn't returned to the source
+static void UngetChar(int c)
+{
+    if (c != EOF)
+        --source_position;
 }
 
 char NextChar()
 {
-    int c = getchar();
-    ungetc(c, stdin);
-    return c;
+    return source_position < source_length ? source[source_position] : EOF;
 }
 
 CHAR_TYPE GetCharType(char c)
@@ -78,19 +125,19 @@ void ConsumeNumber(Token *token, int *line_number)
     // tracking variable
     int c;
 
-    // vector to put the string value of the token and int/doubles to put the actual value
+    // the number is the span of the source from start to the first character after it
     // if the numbers ends up being a float, we save it as an string (since it can have an exponent, which C doesn't support so we can't save by value)
-    Vector *vector = InitVector();
+    size_t start = source_position;
 
     // boolean values to check which parts the number has (if it's a floating point number)
     // valid float construction: 3.14, or 3e-2 or 3e+2 or 3e2 or 3.14e-2 or 3.14e+2 or 3.14e2
     // so 3e-2.14 would be token 3e-2, . would be another token and 14 would also be a separate token
-    bool has_exponent = false, has_floating_point = false;
+    bool has_floating_point = false;
 
     token->token_type = INTEGER_32;
 
     // TODO: zeroes at the start of the part of a number that is whole are invalid
-    while (isdigit((c = getchar())) || c == '.' || tolower(c) == 'e')
+    while (isdigit((c = ReadChar())) || c == '.' || tolower(c) == 'e')
     { // number can be int/double (double has a '.')
         if (c == '.')
         { // check if we already have a floating point value (in case of doubles)
@@ -99,87 +146,64 @@ void ConsumeNumber(Token *token, int *line_number)
             if (!has_floating_point)
             {
                 token->token_type = DOUBLE_64;
-                AppendChar(vector, c);
                 has_floating_point = true;
             }
 
             else
             {
-                /*Don't use ErrorExit(here since we need to free memory AFTER printing the message)*/
-                AppendChar(vector, '\0'); // terminate the string for printing
-                fprintf(stderr, "Line %d: Invalid token %s.\n", *line_number, vector->value);
-
-                // free all allocated resources
-                DestroyToken(token);
-                DestroyVector(vector);
-
+                fprintf(stderr, "Line %d: Invalid token %.*s.\n", *line_number, (int)(source_position - 1 - start), source + start);
                 exit(ERROR_LEXICAL);
             }
         }
 
-        // do the same for the exponent part
-        // we need to break the loop if the exponent ends, since it's always at the end
+        // the exponent part, we need to break the loop if the exponent ends, since it's always at the end
         else if (tolower(c) == 'e')
         {
-            if (!has_exponent)
+            UngetChar(c);
+            if (!ConsumeExponent(token, has_floating_point))
             {
-                ungetc(c, stdin);
-                if (!ConsumeExponent(vector, token, has_floating_point))
-                {
-                    break;
-                }
-
-                else
-                    token->token_type = DOUBLE_64;
+                break;
             }
-        }
 
-        // c is a number
-        else
-            AppendChar(vector, c);
+            else
+                token->token_type = DOUBLE_64;
+        }
     }
 
-    // terminate the vector
-    AppendChar(vector, '\0');
-
     // c is the first character after the number, so put it back to the stream
-    ungetc(c, stdin);
+    UngetChar(c);
+    size_t length = source_position - start;
 
-    // Sprintf to a string
+    // Sprintf to a string, the span is terminated in place for strtod() and restored afterwards
     if (token->token_type == DOUBLE_64)
     {
-        double float_res = strtod(vector->value, NULL);
-        unsigned long length = snprintf(NULL, 0, "%lf", float_res);
-        if ((token->attribute = malloc((length + 1) * sizeof(char))) == NULL)
-            ErrorExit(ERROR_INTERNAL, "Memory allocation failed");
-
-        sprintf(token->attribute, "%lf", float_res);
-        DestroyVector(vector);
+        char after = source[source_position];
+        source[source_position] = '\0';
+        double float_res = strtod(source + start, NULL);
+        source[source_position] = after;
+
+        unsigned long float_length = snprintf(NULL, 0, "%lf", float_res);
+        char formatted[float_length + 1];
+        sprintf(formatted, "%lf", float_res);
+        token->attribute = Intern(formatted);
         return;
     }
 
     // copy the number to the token's value
-    if ((token->attribute = malloc(vector->length * sizeof(char))) == NULL)
-        ErrorExit(ERROR_INTERNAL, "Memory allocation failed");
-
-    // the float is saved as a char* since it can contain an exponent
-    strcpy((token->attribute), vector->value);
+    token->attribute = InternString(source + start, length);
 
     // Check the leading zeroes, // TODO: check
-    if (token->token_type == INTEGER_32 && strlen(token->attribute) > 1 && token->attribute[0] == '0' && token->attribute[1] == '0')
+    if (token->token_type == INTEGER_32 && length > 1 && token->attribute[0] == '0' && token->attribute[1] == '0')
     {
         fprintf(stderr, "Line %d: Invalid token %s\n", *line_number, token->attribute);
-        DestroyToken(token);
         exit(ERROR_LEXICAL);
     }
-
-    DestroyVector(vector);
 }
 
-bool ConsumeExponent(Vector *vector, Token *token, bool has_floating_point)
+bool ConsumeExponent(Token *token, bool has_floating_point)
 {
-    // at the start getchar() will return 'e'/'E' since we used ungetc()
-    int c = getchar();
+    // at the start ReadChar() will return 'e'/'E' since we used UngetChar()
+    ReadChar();
 
     /*reminder: valid float construction:
     3.14, or 3e-2 or 3e+2 or 3e2 or 3.14e-2 or 3.14e+2 or 3.14e2
@@ -189,88 +213,71 @@ bool ConsumeExponent(Vector *vector, Token *token, bool has_floating_point)
     int next;
     if ((next = NextChar()) == '+' || next == '-' || isdigit(next))
     {
-        AppendChar(vector, c);
-        AppendChar(vector, next);
-        getchar(); // move the stream forward
+        ReadChar(); // move the stream forward
     }
 
     else
-    { // return 'e'/'E' to the stream, the token stays a number
+    { // 'e'/'E' is returned to the stream by ConsumeNumber, the token stays a number
         if (!has_floating_point)
             token->token_type = INTEGER_32;
         return false;
     }
 
-    // here we found a digit/sign and appended it, so the only thing that remains is to append remaining digits
-    while (isdigit(c = getchar()))
-        AppendChar(vector, c);
+    // here we found a digit/sign, so the only thing that remains is to skip the remaining digits
+    while (source_position < source_length && isdigit((unsigned char)source[source_position]))
+        ++source_position;
 
-    // unget the last character after the numbers so that the scanner can process it
-    ungetc(c, stdin);
     return true;
 }
 
 void ConsumeIdentifier(Token *token, int *line_number)
 {
-    // needed variables
-    int c;
-    Vector *vector = InitVector();
+    // the identifier is the span of the source from start to the first character that can't be in it
+    size_t start = source_position;
+    int c = ReadChar();
 
     // lone '_' identifier case
-    if ((c = getchar()) == '_' && !isalnum(NextChar()) && NextChar() != '_')
+    if (c == '_' && !isalnum(NextChar()) && NextChar() != '_')
     {
         token->token_type = UNDERSCORE_TOKEN;
-        token->attribute = strdup("_");
+        token->attribute = Intern("_");
         token->line_number = *line_number;
-        DestroyVector(vector);
         return;
     }
 
-    // append the characters until we reach the end of the identifier
-    AppendChar(vector, c);
-    while (isalnum(c = getchar()) || c == '_')
-    {
-        AppendChar(vector, c);
-    }
+    // move past the characters until we reach the end of the identifier
+    while (source_position < source_length && (isalnum((unsigned char)source[source_position]) || source[source_position] == '_'))
+        ++source_position;
 
-    if (c == '\n')
-        ++(*line_number);
-    else
-        ungetc(c, stdin);
+    // copy the span to the token's attribute (the identifier name)
+    size_t length = source_position - start;
+    token->attribute = InternString(source + start, length);
 
-    // terminate the vector
-    AppendChar(vector, '\0');
-
-    // copy the vector's value to the token's attribute (the identifier name)
-    if ((token->attribute = malloc(vector->length * sizeof(char))) == NULL)
+    // a newline right after the identifier is consumed here
+    if (NextChar() == '\n')
     {
-        DestroyVector(vector);
-        DestroyToken(token);
-        ErrorExit(ERROR_INTERNAL, "Memory allocation failed");
+        ++source_position;
+        ++(*line_number);
     }
 
-    strcpy(token->attribute, vector->value);
-    DestroyVector(vector);
-
     // check if the token isn't an invalid one with a prefix
     if (token->attribute[0] == '?')
     {
-        if (!IsValidPrefix(token->attribute))
+        if (!IsValidPrefix(token->attribute, length))
         {
             fprintf(stderr, RED "Error in lexical analysis: Line %d: Invalid token %s\n" RESET, *line_number, token->attribute);
-            DestroyToken(token);
             exit(ERROR_LEXICAL);
         }
 
         token->token_type = KEYWORD;
-        token->keyword_type = IsKeyword(token->attribute);
+        token->keyword_type = IsKeyword(token->attribute, length);
 
         return;
     }
 
     // check if the identifier isn't actually a keyword
     KEYWORD_TYPE keyword_type;
-    if ((keyword_type = IsKeyword(token->attribute)) == NONE)
+    if ((keyword_type = IsKeyword(token->attribute, length)) == NONE)
     {
         token->token_type = IDENTIFIER_TOKEN;
     }
@@ -287,73 +294,62 @@ void ConsumeIdentifier(Token *token, int *line_number)
 void ConsumeLiteral(Token *token, int *line_number)
 {
     int c;
-    Vector *vector = InitVector();
+
+    // escape sequences are decoded in place, over the part of the source that was already read
+    // (the decoded string is never longer), then the string is copied to the token once
+    size_t start = source_position;
+    size_t length = 0;
 
     // loop until we encounter another " character
-    while ((c = getchar()) != '"' && c != '\n' && c != EOF)
+    while ((c = ReadChar()) != '"' && c != '\n' && c != EOF)
     {
         if (c != '\\')
-            AppendChar(vector, c);
+            source[start + length++] = c;
         else
         { // possible escape sequence
-            switch (c = getchar())
+            switch (c = ReadChar())
             {
             // all possible \x characters
             case '"':
-                AppendChar(vector, '\"');
+                source[start + length++] = '\"';
                 break;
 
             case 'n':
-                AppendChar(vector, '\n');
+                source[start + length++] = '\n';
                 break;
 
             case 'r':
-                AppendChar(vector, '\r');
+                source[start + length++] = '\r';
                 break;
 
             case 't':
-                AppendChar(vector, '\t');
+                source[start + length++] = '\t';
                 break;
 
             case 'x':
-                ConsumeHexadecimalEscapeSequence(vector, line_number);
+                source[start + length++] = ConsumeHexadecimalEscapeSequence(line_number);
                 break;
 
             case '\\':
-                AppendChar(vector, c);
+                source[start + length++] = c;
                 break;
 
             // invalid escape sequence, throw a lexical error
             default:
-                DestroyToken(token);
-                DestroyVector(vector);
                 ErrorExit(ERROR_LEXICAL, "Line %d: Invalid escape sequence '/%c' in a literal", *line_number, c);
             }
         }
     }
 
-    // terminate the string
-    AppendChar(vector, '\0');
-
     // either a valid end of a string, or throw an error in case of newline/end of file
     switch (c)
     {
     case '"': // valid string ending, copy the string to the token's attribute
-        if ((token->attribute = malloc(vector->length * sizeof(char))) == NULL)
-        {
-            DestroyToken(token);
-            DestroyVector(vector);
-            ErrorExit(ERROR_INTERNAL, "Memory allocation failed");
-        }
-
-        strcpy(token->attribute, vector->value);
-        DestroyVector(vector);
+        token->attribute = InternString(source + start, length);
         break;
 
     case '\n':
     case EOF:
-        DestroyToken(token);
-        DestroyVector(vector);
         ErrorExit(ERROR_LEXICAL, "Line %d: String missing a second \"", *line_number);
     }
 }
@@ -361,24 +357,25 @@ void ConsumeLiteral(Token *token, int *line_number)
 void ConsumeMultiLineLiteral(Token *token, int *line_number)
 {
     int c;
-    Vector *vector = InitVector();
+
+    // the lines are joined in place like in ConsumeLiteral, the '\\' prefixes are always longer than the '\n' between lines
+    size_t start = source_position;
+    size_t length = 0;
 
     // At the start, we are after the initial '\\' duo
     while (true)
     {
-        c = getchar();
+        c = ReadChar();
 
         // Non-escape sequence or newline characters
         if (c != '\n' && c != EOF)
         {
-            AppendChar(vector, c);
+            source[start + length++] = c;
             continue;
         }
 
         else if (c == EOF)
         {
-            DestroyToken(token);
-            DestroyVector(vector);
             ErrorExit(ERROR_LEXICAL, "Line %d: Unexpected end of file", *line_number);
         }
 
@@ -387,7 +384,7 @@ void ConsumeMultiLineLiteral(Token *token, int *line_number)
             ++(*line_number);
             if (DoesMultiLineLiteralContinue(line_number))
             {
-                AppendChar(vector, '\n');
+                source[start + length++] = '\n';
                 continue;
             }
             else
@@ -395,24 +392,20 @@ void ConsumeMultiLineLiteral(Token *token, int *line_number)
         }
     }
 
-    // Terminate the string
-    AppendChar(vector, '\0');
-
     // Copy the string to the token's attribute
-    token->attribute = strdup(vector->value);
-    DestroyVector(vector);
+    token->attribute = InternString(source + start, length);
 }
 
 bool DoesMultiLineLiteralContinue(int *line_number)
 {
     int c;
-    while ((c = getchar()) != EOF)
+    while ((c = ReadChar()) != EOF)
     {
         if (c != '\\' && c != '\n')
         {
             if (!isspace(c))
             {
-                ungetc(c, stdin);
+                UngetChar(c);
                 return false;
             }
         }
@@ -427,40 +420,37 @@ bool DoesMultiLineLiteralContinue(int *line_number)
         {
             if ((c = NextChar()) == '\\')
             {
-                getchar();
+                ReadChar();
                 return true;
             }
 
             else
             {
-                ungetc(c, stdin);
+                UngetChar(c);
                 return false;
             }
         }
     }
 
-    ungetc(c, stdin);
     return false;
 }
 
-void ConsumeHexadecimalEscapeSequence(Vector *vector, int *line_number)
+char ConsumeHexadecimalEscapeSequence(int *line_number)
 {
     int c;
     char digit_1, digit_2;
 
     // Do this twice :))
-    if (!isdigit(c = getchar()))
+    if (!isdigit(c = ReadChar()))
     {
-        DestroyVector(vector);
         ErrorExit(ERROR_LEXICAL, "Line %d: Invalid hexadecimal escape sequence '\\x%c'", *line_number, c);
     }
 
     else
         digit_1 = c;
 
-    if (!isdigit(c = getchar()))
+    if (!isdigit(c = ReadChar()))
     {
-        DestroyVector(vector);
         ErrorExit(ERROR_LEXICAL, "Line %d: Invalid hexadecimal escape sequence '\\x%c'", *line_number, c);
     }
 
@@ -469,56 +459,52 @@ void ConsumeHexadecimalEscapeSequence(Vector *vector, int *line_number)
 
     // Convert the two digits to a hexadecimal number
     char hex[3] = {digit_1, digit_2, '\0'};
-    int value = strtol(hex, NULL, 16);
-
-    // Append the character to the vector
-    AppendChar(vector, value);
+    return strtol(hex, NULL, 16);
 }
 
 int ConsumeComment(int *line_number)
 {
-    int c;
-    while ((c = getchar()) != '\n' && c != EOF)
+    // skip straight to the end of the line
+    char *end = memchr(source + source_position, '\n', source_length - source_position);
+    if (end == NULL)
     {
-        continue;
+        source_position = source_length;
+        return EOF;
     }
 
-    if (c == '\n')
-        ++(*line_number);
-    return c;
+    source_position = end - source + 1;
+    ++(*line_number);
+    return '\n';
 }
 
 void ConsumeImportToken(Token *token, int *line_number)
 {
     const char import[8] = "@import";
-    int c;
     // compare until we reach the end, or throw an error (@ is an invalid token by itself)
 
     for (int i = 0; i < 7; i++)
     {
-        if ((c = getchar()) != import[i])
+        if (ReadChar() != import[i])
         {
-            DestroyToken(token);
             ErrorExit(ERROR_LEXICAL, "Line %d: Invalid token '@'", *line_number);
         }
     }
 
     // token is valid
     token->token_type = IMPORT_TOKEN;
-    token->attribute = strdup("@import");
+    token->attribute = Intern("@import");
 }
 
 int ConsumeWhitespace(int *line_number)
 {
-    int c;
-    while (isspace(c = getchar()) && c != EOF)
+    while (source_position < source_length && isspace((unsigned char)source[source_position]))
     {
-        if (c == '\n')
+        if (source[source_position] == '\n')
             ++(*line_number);
-        continue;
+        ++source_position;
     }
 
-    return c;
+    return ReadChar();
 }
 
 void ConsumeU8Token(Token *token, int *line_number)
@@ -534,7 +520,7 @@ void ConsumeU8Token(Token *token, int *line_number)
     int length = NextChar() == '?' ? 5 : 4;
     for (i = 0; i < length; i++)
     {
-        c = getchar();
+        c = ReadChar();
 
         if ((c != u8_token[i] && i != 5) && (c != nullable_u8_token[i]))
         {
@@ -550,56 +536,34 @@ void ConsumeU8Token(Token *token, int *line_number)
     actual_token[i] = '\0';
 
     // copy the u8[] string to the token
-    if ((token->attribute = malloc((length + 1) * sizeof(char))) == NULL)
-    {
-        DestroyToken(token);
-        ErrorExit(ERROR_INTERNAL, "Memory allocation failed");
-    }
-
-    strcpy(token->attribute, actual_token);
+    token->attribute = Intern(actual_token);
 
     token->line_number = *line_number;
     token->token_type = KEYWORD;
     token->keyword_type = U8;
 }
 
-KEYWORD_TYPE IsKeyword(char *attribute)
+KEYWORD_TYPE IsKeyword(char *attribute, size_t length)
 {
-    // create a array of keywords(sice it's constant)
-    const char keyword_strings[][KEYWORD_COUNT] = {
-        "const",
-        "else",
-        "fn",
-        "if",
-        "i32",
-        "f64",
-        "null",
-        "pub",
-        "return",
-        "u8",
-        "var",
-        "void",
-        "while"};
-
-    if (attribute[0] == '?')
+    if (length > 0 && attribute[0] == '?')
     {
-        return IsKeyword(attribute + 1);
+        return IsKeyword(attribute + 1, length - 1);
     }
 
-    for (int i = 0; i < KEYWORD_COUNT; i++)
-    {
-        if (!strcmp(attribute, keyword_strings[i]))
-        {
-            return i;
-        }
-    }
+    // one probe into the perfect hash, then compare with the only keyword that can match
+    if (length == 0 || length >= MAXLENGTH_KEYWORD)
+        return NONE;
 
-    return NONE;
+    KEYWORD_TYPE keyword = keyword_hash_table[NAME_HASH(attribute, length)];
+    if (keyword == NONE || keyword_types[keyword][length] != '\0' || memcmp(keyword_types[keyword], attribute, length))
+        return NONE;
+
+    return keyword;
 }
 
-bool IsValidPrefix(char *identifier)
+bool IsValidPrefix(char *identifier, size_t length)
 {
-    return IsKeyword(identifier + 1) == NONE ? false : true;
+    return IsKeyword(identifier + 1, length - 1) == NONE ? false : true;
 }
 
 Token *LoadTokenFromStream(int *line_number)
@@ -607,32 +571,37 @@ Token *LoadTokenFromStream(int *line_number)
     // initial variables
     int c;
     char next;
-    Token *token = InitToken();
+    Token *token = InitToken(&token_arena);
+
+    // the whole input is read on the first call
+    if (!source_loaded)
+        LoadSource();
 
     // skip all the whitespace character and
     // return the first non-whitespace character or end the function at the end of the file
     if ((c = ConsumeWhitespace(line_number)) == EOF)
     {
+        DestroySource();
         token->token_type = EOF_TOKEN;
         return token;
     }
 
     while (true)
     {
-        switch (c = (isspace(c)) ? getchar() : c)
+        switch (c = (isspace(c)) ? ReadChar() : c)
         {
         /*operator tokens*/
         case '=': // valid tokens are = and also ==
             if ((c = NextChar()) == '=')
             {
-                getchar();
-                token->attribute = strdup("==");
+                ReadChar();
+                token->attribute = Intern("==");
                 token->token_type = EQUAL_OPERATOR;
             }
 
             else
             {
-                token->attribute = strdup("=");
+                token->attribute = Intern("=");
                 token->token_type = ASSIGNMENT;
             }
 
@@ -640,19 +609,19 @@ Token *LoadTokenFromStream(int *line_number)
             return token;
 
         case '+':
-            token->attribute = strdup("+");
+            token->attribute = Intern("+");
             token->token_type = ADDITION_OPERATOR;
             token->line_number = *line_number;
             return token;
 
         case '-':
-            token->attribute = strdup("-");
+            token->attribute = Intern("-");
             token->token_type = SUBSTRACTION_OPERATOR;
             token->line_number = *line_number;
             return token;
 
         case '*':
-            token->attribute = strdup("*");
+            token->attribute = Intern("*");
             token->token_type = MULTIPLICATION_OPERATOR;
             token->line_number = *line_number;
             return token;
@@ -660,14 +629,14 @@ Token *LoadTokenFromStream(int *line_number)
         case '/': // can also signal the start of a comment
             if ((next = NextChar()) != '/')
             {
-                token->attribute = strdup("/");
+                token->attribute = Intern("/");
                 token->token_type = DIVISION_OPERATOR;
                 token->line_number = *line_number;
                 return token;
             }
 
             // indicates the start of a comment --> consume the second '/' character and skip to the end of the line/file
-            getchar();
+            ReadChar();
             c = ConsumeComment(line_number);
 
             // run the switch again with the first character after the comment ends
@@ -682,8 +651,8 @@ Token *LoadTokenFromStream(int *line_number)
 
             else
             {
-                token->attribute = strdup("!=");
-                getchar();
+                token->attribute = Intern("!=");
+                ReadChar();
                 token->line_number = *line_number;
                 token->token_type = NOT_EQUAL_OPERATOR;
             }
@@ -693,14 +662,14 @@ Token *LoadTokenFromStream(int *line_number)
         case '<': //< is a valid token, but so is <=
             if ((next = NextChar()) != '=')
             {
-                token->attribute = strdup("<");
+                token->attribute = Intern("<");
                 token->token_type = LESS_THAN_OPERATOR;
             }
 
             else
             {
-                token->attribute = strdup("<=");
-                getchar(); // consume the = character
+                token->attribute = Intern("<=");
+                ReadChar(); // consume the = character
                 token->token_type = LESSER_EQUAL_OPERATOR;
             }
 
@@ -710,14 +679,14 @@ Token *LoadTokenFromStream(int *line_number)
         case '>': // analogous to <
             if ((next = NextChar()) != '=')
             {
-                token->attribute = strdup(">");
+                token->attribute = Intern(">");
                 token->token_type = LARGER_THAN_OPERATOR;
             }
 
             else
             {
-                token->attribute = strdup(">=");
-                getchar();
+                token->attribute = Intern(">=");
+                ReadChar();
                 token->token_type = LARGER_EQUAL_OPERATOR;
             }
 
@@ -726,36 +695,36 @@ Token *LoadTokenFromStream(int *line_number)
 
         /*bracket tokens and array symbol*/
         case '(':
-            token->attribute = strdup("(");
+            token->attribute = Intern("(");
             token->token_type = L_ROUND_BRACKET;
             token->line_number = *line_number;
             return token;
 
         case ')':
-            token->attribute = strdup(")");
+            token->attribute = Intern(")");
             token->token_type = R_ROUND_BRACKET;
             token->line_number = *line_number;
             return token;
 
         case '{':
-            token->attribute = strdup("{");
+            token->attribute = Intern("{");
             token->token_type = L_CURLY_BRACKET;
             token->line_number = *line_number;
             return token;
 
         case '}':
-            token->attribute = strdup("}");
+            token->attribute = Intern("}");
             token->token_type = R_CURLY_BRACKET;
             token->line_number = *line_number;
             return token;
 
         case '[': // A bit of a special case, []u8 is a keyword that can't be mistaken for a identifier but u8 can but u8 by itself is a invalid token
-            ungetc(c, stdin);
+            UngetChar(c);
             ConsumeU8Token(token, line_number);
             return token;
 
         case '|':
-            token->attribute = strdup("|");
+            token->attribute = Intern("|");
             token->token_type = VERTICAL_BAR_TOKEN;
             token->line_number = *line_number;
             return token;
@@ -763,7 +732,7 @@ Token *LoadTokenFromStream(int *line_number)
         /*special symbols*/
         case '?':
             next = NextChar();
-            ungetc(c, stdin);
+            UngetChar(c);
 
             if (isalnum(next))
                 ConsumeIdentifier(token, line_number);
@@ -775,42 +744,43 @@ Token *LoadTokenFromStream(int *line_number)
             return token;
 
         case EOF:
+            DestroySource();
             token->token_type = EOF_TOKEN;
             token->line_number = *line_number;
             return token;
 
         case ';':
-            token->attribute = strdup(";");
+            token->attribute = Intern(";");
             token->token_type = SEMICOLON;
             token->line_number = *line_number;
             return token;
 
         case '_':
-            ungetc(c, stdin);
+            UngetChar(c);
             ConsumeIdentifier(token, line_number);
             token->line_number = *line_number;
             return token;
 
         case '@':
-            ungetc(c, stdin);
+            UngetChar(c);
             ConsumeImportToken(token, line_number);
             token->line_number = *line_number;
             return token;
 
         case ':':
-            token->attribute = strdup(":");
+            token->attribute = Intern(":");
             token->token_type = COLON_TOKEN;
             token->line_number = *line_number;
             return token;
 
         case '.':
-            token->attribute = strdup(".");
+            token->attribute = Intern(".");
             token->token_type = DOT_TOKEN;
             token->line_number = *line_number;
             return token;
 
         case ',':
-            token->attribute = strdup(",");
+            token->attribute = Intern(",");
             token->token_type = COMMA_TOKEN;
             token->line_number = *line_number;
             return token;
@@ -827,7 +797,7 @@ Token *LoadTokenFromStream(int *line_number)
             if (isdigit(next = NextChar()))
                 ErrorExit(ERROR_LEXICAL, "Line %d: Invalid token '0%c'", *line_number, next);
 
-            ungetc(c, stdin);
+            UngetChar(c);
             ConsumeNumber(token, line_number);
 
             token->line_number = *line_number;
@@ -837,7 +807,7 @@ Token *LoadTokenFromStream(int *line_number)
         case '\\':
             if ((next = NextChar()) == '\\')
             {
-                getchar();
+                ReadChar();
                 token->token_type = LITERAL_TOKEN;
                 token->line_number = *line_number;
                 ConsumeMultiLineLiteral(token, line_number);
@@ -856,7 +826,7 @@ Token *LoadTokenFromStream(int *line_number)
         /*call GetSymbolType to determine next token*/
         default:
             // return the character back, since the consume functions parse the whole token
-            ungetc(c, stdin);
+            UngetChar(c);
 
             // call a sub-FSM function depending on the char type
             switch (GetCharType(c))
@@ -8,9 +8,12 @@
 #ifndef SCANNER_H
 #define SCANNER_H
 
+#include <stddef.h>
+
 #include "types.h"
 
 #define KEYWORD_COUNT 13
+#define SOURCE_CHUNK_SIZE 65536 // initial size of the source buffer when stdin isn't a regular file
 
 /**
  * @brief Gets next token from the input stream (skipping whitespace)
@@ -20,16 +23,22 @@
  */
 Token *LoadTokenFromStream(int *line_number);
 
-// Token constructor
-Token *InitToken();
+// Token constructor, token_arena for the token stream, scratch_arena for tokens of a single statement
+Token *InitToken(Arena *arena);
 
-// Retuns a copy of the token passed as a parameter to avoid double freeing
+// Retuns a copy of the token passed as a parameter, allocated in scratch_arena (released after the statement)
 Token *CopyToken(Token *token);
 
-// Token destructor
+// Token destructor, tokens are released in bulk with their arena so this doesn't free anything
 void DestroyToken(Token *token);
 
-// Returns the next character from stdin without moving forward (it returns the character back)
+// Reads the whole stdin into the source buffer, the scanner then works by position over it instead of getchar()/ungetc()
+void LoadSource();
+
+// Frees the source buffer, called once the EOF token is produced (token attributes are copies in token_arena)
+void DestroySource();
+
+// Returns the next character of the source without moving forward
 char NextChar();
 
 /**
@@ -51,12 +60,11 @@ void ConsumeNumber(Token *token, int *line_number);
 /**
  * @brief Helper function for ConsumeNumber, consumes the number's exponent
  *
- * @param vector Vector to add characters to
  * @param token To change the type if needed
  * @param has_floating_point a flag if the token is a valid DOUBLE_64 token even without the exponent
  * @return bool A flag to let ConsumeNumber know whether to end the loop or not
  */
-bool ConsumeExponent(Vector *vector, Token *token, bool has_floating_point);
+bool ConsumeExponent(Token *token, bool has_floating_point);
 
 /**
  * @brief Handles a string literal
@@ -78,10 +86,10 @@ bool DoesMultiLineLiteralContinue(int *line_number);
 /**
  * @brief Consumes and validates a escape sequence of the form \xHH in a literal
  *
- * @param vector Vector containing the overlapping literal
  * @param line_number Current line number
+ * @return char The character the sequence stands for
  */
-void ConsumeHexadecimalEscapeSequence(Vector *vector, int *line_number);
+char ConsumeHexadecimalEscapeSequence(int *line_number);
 
 /**
  * @brief Handles a multi-line string literal
@@ -119,15 +127,16 @@ int ConsumeWhitespace(int *line_number);
 void ConsumeU8Token(Token *token, int *line_number);
 
 // checks if a identifier with a prefix at the start is valid or not (so if it's a keyword)
-bool IsValidPrefix(char *identifier);
+bool IsValidPrefix(char *identifier, size_t length);
 
 /**
- * @brief Checks if the token passed is a keyword
+ * @brief Checks if the token passed is a keyword, using the perfect hash NAME_HASH from shared.h
  *
  * @param attribute The given string
+ * @param length Length of the string
  * @return KEYWORD_TYPE NONE if not a keyword, otherwise the which one it is
  */
-KEYWORD_TYPE IsKeyword(char *attribute);
+KEYWORD_TYPE IsKeyword(char *attribute, size_t length);
 
 // debug function
 void PrintToken(Token *token);
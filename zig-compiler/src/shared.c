@@ -63,6 +63,18 @@ const char keyword_types[KEYWORD_COUNT][MAXLENGTH_KEYWORD] = {
     "void",
     "while"};
 
+const KEYWORD_TYPE keyword_hash_table[NAME_HASH_SIZE] = {
+    NONE, NONE, NONE, NONE, IF, NONE, NONE, VOID,
+    CONST, F64, U8, WHILE, NONE, NONE, I32, NONE,
+    NONE, NONE, NONE, RETURN, VAR, NULL_TYPE, NONE, NONE,
+    PUB, NONE, NONE, NONE, FN, NONE, ELSE, NONE};
+
+const int embedded_hash_table[NAME_HASH_SIZE] = {
+    -1, 4, -1, -1, 2, -1, -1, -1,
+    -1, 8, 10, -1, -1, -1, -1, 7,
+    -1, -1, 1, 5, 6, 11, -1, 12,
+    0, -1, -1, -1, -1, 3, 9, -1};
+
 const char embedded_names[EMBEDDED_FUNCTION_COUNT][MAXLENGTH_EMBEDDED_FUNCTION] = {
     "readstr",
     "readi32",
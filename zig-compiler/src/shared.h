@@ -23,6 +23,15 @@
 #define KEYWORD_COUNT 13
 #define MAXLENGTH_KEYWORD 10
 
+// Perfect hash of the keyword and embedded function names: no two names of the same table share a slot,
+// so a lookup is one probe and one comparison. The multipliers come from a search over small constants,
+// adding a name to either table means searching again and regenerating both tables in shared.c
+#define NAME_HASH_SIZE 32
+#define NAME_HASH(name, length)                                          \
+    (((length) + 5 * (unsigned char)(name)[(length) > 1 ? 1 : 0] +       \
+      6 * (unsigned char)(name)[(length) > 5 ? 5 : (length) - 1]) %      \
+     NAME_HASH_SIZE)
+
 // Extern variables to keep track of labels for easier jumping
 extern int if_label_count;
 extern int while_label_count;
@@ -36,6 +45,12 @@ extern const char token_types[TOKEN_COUNT][MAXLENGTH_TOKEN];
 // Contains string representation of keyword types
 extern const char keyword_types[KEYWORD_COUNT][MAXLENGTH_KEYWORD];
 
+// Keyword in each slot of the keyword name hash, NONE for empty slots
+extern const KEYWORD_TYPE keyword_hash_table[NAME_HASH_SIZE];
+
+// Index into embedded_names for each slot of the embedded function name hash, -1 for empty slots
+extern const int embedded_hash_table[NAME_HASH_SIZE];
+
 // Contains the names of all embedded function names
 extern const char embedded_names[EMBEDDED_FUNCTION_COUNT][MAXLENGTH_EMBEDDED_FUNCTION];
 
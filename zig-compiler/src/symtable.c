@@ -20,6 +20,8 @@
 #include "stack.h"
 #include "shared.h"
 #include "vector.h"
+#include "arena.h"
+#include "atom.h"
 
 Symtable *InitSymtable(unsigned long size)
 {
@@ -38,13 +40,40 @@ Symtable *InitSymtable(unsigned long size)
         ErrorExit(ERROR_INTERNAL, "Memory allocation failed");
     }
 
-    for (unsigned long i = 0; i < size; i++)
+    return symtable;
+}
+
+void GrowSymtable(Symtable *symtable)
+{
+    if ((double)(symtable->size + 1) <= symtable->capacity * TABLE_MAX_LOAD)
+        return;
+
+    // keep the capacity odd, the sdbm hash is taken modulo the capacity
+    unsigned long capacity = symtable->capacity * 2 + 1;
+    HashEntry *table = calloc(capacity, sizeof(HashEntry));
+    if (!table)
     {
-        symtable->table[i].is_occupied = false;
-        symtable->table[i].symbol = NULL;
+        ErrorExit(ERROR_INTERNAL, "Memory allocation failed");
     }
 
-    return symtable;
+    for (unsigned long i = 0; i < symtable->capacity; i++)
+    {
+        if (!symtable->table[i].is_occupied)
+            continue;
+
+        char *name = symtable->table[i].symbol_type == FUNCTION_SYMBOL
+                         ? ((FunctionSymbol *)symtable->table[i].symbol)->name
+                         : ((VariableSymbol *)symtable->table[i].symbol)->name;
+        unsigned long index = GetSymtableHash(name, capacity);
+        while (table[index].is_occupied)
+            index = (index + 1) % capacity;
+
+        table[index] = symtable->table[i];
+    }
+
+    free(symtable->table);
+    symtable->table = table;
+    symtable->capacity = capacity;
 }
 
 void DestroySymtable(Symtable *symtable)
@@ -115,11 +144,8 @@ void AppendStringArray(StringArray *string_array, char *string)
 
 FunctionSymbol *FunctionSymbolInit(void)
 {
-    FunctionSymbol *function_symbol;
-    if ((function_symbol = calloc(1, sizeof(FunctionSymbol))) == NULL)
-    {
-        ErrorExit(ERROR_INTERNAL, "Memory allocation failed");
-    }
+    FunctionSymbol *function_symbol = ArenaAlloc(&symbol_arena, sizeof(FunctionSymbol));
+    memset(function_symbol, 0, sizeof(FunctionSymbol));
     InitStringArray(&function_symbol->variables);
 
     return function_symbol;
@@ -127,11 +153,8 @@ FunctionSymbol *FunctionSymbolInit(void)
 
 VariableSymbol *VariableSymbolInit(void)
 {
-    VariableSymbol *variable_symbol;
-    if ((variable_symbol = calloc(1, sizeof(VariableSymbol))) == NULL)
-    {
-        ErrorExit(ERROR_INTERNAL, "Memory allocation failed");
-    }
+    VariableSymbol *variable_symbol = ArenaAlloc(&symbol_arena, sizeof(VariableSymbol));
+    memset(variable_symbol, 0, sizeof(VariableSymbol));
 
     variable_symbol->type = VOID_TYPE; // Default
 
@@ -144,7 +167,7 @@ VariableSymbol *VariableSymbolCopy(VariableSymbol *var)
 
     copy->defined = var->defined;
     copy->is_const = var->is_const;
-    copy->name = var->name == NULL ? NULL : strdup(var->name);
+    copy->name = var->name;
     copy->nullable = var->nullable;
     copy->type = var->type;
 
@@ -156,9 +179,7 @@ void DestroyFunctionSymbol(FunctionSymbol *function_symbol)
     if (function_symbol == NULL)
         return; // just in case
 
-    if (function_symbol->name != NULL)
-        free(function_symbol->name);
-
+    // the record and its name live in symbol_arena, only the arrays are freed here
     // free all parameters
     for (int i = 0; i < function_symbol->num_of_parameters; i++)
     {
@@ -178,34 +199,18 @@ void DestroyFunctionSymbol(FunctionSymbol *function_symbol)
 
     if (function_symbol->parameters != NULL)
         free(function_symbol->parameters);
-
-    free(function_symbol);
 }
 
 void DestroyVariableSymbol(VariableSymbol *variable_symbol)
 {
-    if (variable_symbol == NULL)
-        return;
-
-    if (variable_symbol->name != NULL)
-        free(variable_symbol->name);
-
-    if (variable_symbol->value != NULL)
-        free(variable_symbol->value);
-
-    free(variable_symbol);
+    // the record, its name and value live in symbol_arena and are released with it
+    (void)variable_symbol;
 }
 
 unsigned long GetSymtableHash(char *symbol_name, unsigned long modulo)
 {
-    unsigned int hash = 0;
-    const unsigned char *p;
-    for (p = (const unsigned char *)symbol_name; *p != '\0'; p++)
-    {
-        hash = 65599 * hash + *p;
-    }
-
-    return hash % modulo;
+    // the hash was computed once, when the scanner interned the name
+    return GetAtomHash(symbol_name) % modulo;
 }
 
 bool IsSymtableEmpty(Symtable *symtable)
@@ -221,7 +226,7 @@ FunctionSymbol *FindFunctionSymbol(Symtable *symtable, char *function_name)
     while (symtable->table[index].is_occupied)
     {
         if (symtable->table[index].symbol_type == FUNCTION_SYMBOL &&
-            strcmp(((FunctionSymbol *)symtable->table[index].symbol)->name, function_name) == 0)
+            ((FunctionSymbol *)symtable->table[index].symbol)->name == function_name)
         {
             return (FunctionSymbol *)symtable->table[index].symbol;
         }
@@ -244,7 +249,7 @@ VariableSymbol *FindVariableSymbol(Symtable *symtable, char *variable_name)
     while (symtable->table[index].is_occupied)
     {
         if (symtable->table[index].symbol_type == VARIABLE_SYMBOL &&
-            strcmp(((VariableSymbol *)symtable->table[index].symbol)->name, variable_name) == 0)
+            ((VariableSymbol *)symtable->table[index].symbol)->name == variable_name)
         {
             return (VariableSymbol *)symtable->table[index].symbol;
         }
@@ -261,9 +266,6 @@ VariableSymbol *FindVariableSymbol(Symtable *symtable, char *variable_name)
 
 void InsertVariableSymbol(Parser *parser, VariableSymbol *variable_symbol)
 {
-    unsigned long index = GetSymtableHash(variable_symbol->name, parser->symtable->capacity);
-    unsigned long start_index = index;
-
     if (SymtableStackFindVariable(parser->symtable_stack, variable_symbol->name) != NULL || FindFunctionSymbol(parser->global_symtable, variable_symbol->name) != NULL)
     {
         // Symbol already in table
@@ -273,10 +275,14 @@ void InsertVariableSymbol(Parser *parser, VariableSymbol *variable_symbol)
         ErrorExit(ERROR_SEMANTIC_REDEFINED, "Variable already %s declared on line %d", variable_symbol->name, parser->line_number);
     }
 
+    GrowSymtable(parser->symtable);
+    unsigned long index = GetSymtableHash(variable_symbol->name, parser->symtable->capacity);
+    unsigned long start_index = index;
+
     while (parser->symtable->table[index].is_occupied)
     {
         if (parser->symtable->table[index].symbol_type == VARIABLE_SYMBOL &&
-            strcmp(((VariableSymbol *)parser->symtable->table[index].symbol)->name, variable_symbol->name) == 0)
+            ((VariableSymbol *)parser->symtable->table[index].symbol)->name == variable_symbol->name)
         {
             // Symbol already exists
             SymtableStackDestroy(parser->symtable_stack);
@@ -304,18 +310,19 @@ void InsertVariableSymbol(Parser *parser, VariableSymbol *variable_symbol)
 
 bool InsertFunctionSymbol(Parser *parser, FunctionSymbol *function_symbol)
 {
-    unsigned long index = GetSymtableHash(function_symbol->name, parser->global_symtable->capacity);
-    unsigned long start_index = index;
-
     if (SymtableStackFindVariable(parser->symtable_stack, function_symbol->name) != NULL || FindFunctionSymbol(parser->global_symtable, function_symbol->name) != NULL)
     {
         return false; // Symbol already in table
     }
 
+    GrowSymtable(parser->global_symtable);
+    unsigned long index = GetSymtableHash(function_symbol->name, parser->global_symtable->capacity);
+    unsigned long start_index = index;
+
     while (parser->global_symtable->table[index].is_occupied)
     {
         if (parser->global_symtable->table[index].symbol_type == FUNCTION_SYMBOL &&
-            strcmp(((FunctionSymbol *)parser->global_symtable->table[index].symbol)->name, function_symbol->name) == 0)
+            ((FunctionSymbol *)parser->global_symtable->table[index].symbol)->name == function_symbol->name)
         {
             return false; // Symbol already exists
         }
@@ -19,18 +19,26 @@
 
 #include "types.h"
 
-// symtable constructor with the specified size of linked lists
+// symtable constructor with the specified initial capacity, see GrowSymtable
 Symtable *InitSymtable(unsigned long size);
 
 // symtable destructor, calls DestroyList on every SymtableLinkedList
 void DestroySymtable(Symtable *symtable);
 
+/**
+ * @brief Makes room for one more symbol, rehashes the table into about twice the capacity
+ *        if the insertion would take it over TABLE_MAX_LOAD
+ *
+ * @param symtable table the next symbol is inserted into
+ */
+void GrowSymtable(Symtable *symtable);
+
 /**
  * @brief Hash function for the symtable (which is a Hash table)
  *
- * @param symbol_name name of the symbol, used as an input to the hash function
+ * @param symbol_name name of the symbol, has to be an atom (see atom.h), its stored hash is used
  * @param modulo size of the symtable, the index into the symtable is H(x) % size
- * @note This function is from http://www.cse.yorku.ca/~oz/hash.html -- sdbm variant
+ * @note The hash is from http://www.cse.yorku.ca/~oz/hash.html -- sdbm variant
  * @return unsigned long index into the symtable
  */
 unsigned long GetSymtableHash(char *symbol_name, unsigned long modulo);
@@ -54,6 +62,7 @@ void DestroyVariableSymbol(VariableSymbol *variable_symbol);
 bool IsSymtableEmpty(Symtable *symtable);
 
 // looks if the symbol is in the symtable and returns a pointer to it if yes, else returns NULL
+// names are atoms (see atom.h), so symbols are matched by comparing the name pointers
 FunctionSymbol *FindFunctionSymbol(Symtable *symtable, char *function_name);
 
 // the same but for variables
@@ -19,7 +19,9 @@
 #include <stdbool.h>
 
 // Symtable size
-#define TABLE_COUNT 5009 // first prime over 5000
+#define TABLE_COUNT 5009      // first prime over 5000, global symtable
+#define SCOPE_TABLE_COUNT 11  // initial size of block and function scopes, grown as they fill
+#define TABLE_MAX_LOAD 0.5    // a table is grown before an insertion would exceed this load factor
 
 // Number of precedence table rows/columns
 #define PTABLE_SIZE 14
@@ -203,6 +205,40 @@ typedef struct
     int capacity;         // max
 } TokenVector;
 
+/******************** ARENA (REGION) ALLOCATOR STRUCTURES ********************/
+
+// One block of an arena, allocations are carved from data in order
+typedef struct ArenaChunkNode
+{
+    struct ArenaChunkNode *next;
+    unsigned long size; // bytes available in data
+    unsigned long used; // bytes already handed out
+    char data[];
+} ArenaChunk;
+
+typedef struct
+{
+    ArenaChunk *first;   // chunks stay allocated until DestroyArena and are reused after a release
+    ArenaChunk *current; // chunk the next allocation is tried in
+} Arena;
+
+// Position in an arena, everything allocated after it is released at once by ArenaRelease
+typedef struct
+{
+    ArenaChunk *chunk;
+    unsigned long used;
+} ArenaMark;
+
+/******************** ATOM (INTERNED STRING) STRUCTURES ********************/
+
+// Interned string, the rest of the compiler only sees name and compares atoms by pointer
+typedef struct
+{
+    unsigned int hash;   // sdbm hash of name, computed once when the string is interned
+    unsigned int length; // strlen(name)
+    char name[];
+} Atom;
+
 /******************** STRUCTURES FOR PRECEDENTIAL ANALYSIS ********************/
 
 // Enumeration of grammar rules for reduction in expressions